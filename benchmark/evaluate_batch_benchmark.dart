@@ -0,0 +1,50 @@
+// Measures calculator_evaluate_batch throughput in jobs per second at several thread counts.
+// Every job takes the engine lock, so this shows the cost of batching rather than scaling.
+//
+// Run with: dart run benchmark/evaluate_batch_benchmark.dart
+import 'dart:ffi';
+import 'package:ffi/ffi.dart';
+import 'package:wincalc_engine/wincalc_engine.dart';
+
+const int jobCount = 20000;
+const List<int> threadCounts = [1, 2, 4, 8];
+
+void report(String name, int jobs, Duration elapsed) {
+  final perSecond = jobs / (elapsed.inMicroseconds / Duration.microsecondsPerSecond);
+  print('${name.padRight(28)} ${(perSecond / 1e3).toStringAsFixed(1).padLeft(8)} K jobs/s');
+}
+
+void run(String name, CalcMode mode, String Function(int) expressionFor) {
+  final jobs = calloc<CalcJob>(jobCount);
+  final results = calloc<CalcResult>(jobCount);
+  final expressions = <Pointer<Utf8>>[];
+  try {
+    for (int i = 0; i < jobCount; i++) {
+      final expression = expressionFor(i).toNativeUtf8();
+      expressions.add(expression);
+      jobs[i]
+        ..type = CalcJobType.CALC_JOB_EXPRESSION.value
+        ..mode = mode.value
+        ..expression = expression.cast();
+    }
+
+    // Warm up
+    calculator_evaluate_batch(jobs, jobCount, results, 1);
+
+    for (final threads in threadCounts) {
+      final stopwatch = Stopwatch()..start();
+      final succeeded = calculator_evaluate_batch(jobs, jobCount, results, threads);
+      stopwatch.stop();
+      if (succeeded != jobCount) print('$name: ${jobCount - succeeded} jobs failed');
+      report('$name x$threads', jobCount, stopwatch.elapsed);
+    }
+  } finally {
+    expressions.forEach(calloc.free);
+    calloc.free(jobs);
+    calloc.free(results);
+  }
+}
+
+void main() {
+  run('scientific', CalcMode.CALC_MODE_SCIENTIFIC, (i) => '$i / 7 + (${i % 97} - 3) * 1.5');
+}
@@ -0,0 +1,49 @@
+// Measures unit conversion throughput in elements per second.
+//
+// Run with: dart run benchmark/unit_converter_benchmark.dart
+import 'dart:ffi';
+import 'package:ffi/ffi.dart';
+import 'package:wincalc_engine/wincalc_engine.dart';
+
+const int UNIT_KILOPASCALS = 1001;
+const int UNIT_PSI = 1004;
+const int elementCount = 1000000;
+const int iterations = 20;
+
+void report(String name, int elements, Duration elapsed) {
+  final perSecond = elements / (elapsed.inMicroseconds / Duration.microsecondsPerSecond);
+  print('${name.padRight(28)} ${(perSecond / 1e6).toStringAsFixed(1).padLeft(8)} M elements/s');
+}
+
+void main() {
+  final input = calloc<Double>(elementCount);
+  final output = calloc<Double>(elementCount);
+  final single = calloc<Double>();
+  try {
+    for (int i = 0; i < elementCount; i++) {
+      input[i] = i * 0.01;
+    }
+
+    // Warm up both paths
+    unit_converter_convert_array(UNIT_PSI, UNIT_KILOPASCALS, input, output, elementCount);
+    unit_converter_convert_value(UNIT_PSI, UNIT_KILOPASCALS, input[0], single);
+
+    final stopwatch = Stopwatch()..start();
+    for (int n = 0; n < iterations; n++) {
+      unit_converter_convert_array(UNIT_PSI, UNIT_KILOPASCALS, input, output, elementCount);
+    }
+    report('unit_converter_convert_array', elementCount * iterations, stopwatch.elapsed);
+
+    stopwatch
+      ..reset()
+      ..start();
+    for (int i = 0; i < elementCount; i++) {
+      unit_converter_convert_value(UNIT_PSI, UNIT_KILOPASCALS, input[i], single);
+    }
+    report('unit_converter_convert_value', elementCount, stopwatch.elapsed);
+  } finally {
+    calloc.free(input);
+    calloc.free(output);
+    calloc.free(single);
+  }
+}
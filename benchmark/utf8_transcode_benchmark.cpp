@@ -0,0 +1,96 @@
+// utf8_transcode_benchmark.cpp
+// Compares utf8_transcode.h against the previous scalar wstring_to_utf8 loop
+// on typical calculator display strings.
+//
+// Build and run from the repository root:
+//   c++ -O2 -std=c++17 benchmark/utf8_transcode_benchmark.cpp -o utf8_transcode_benchmark
+//   ./utf8_transcode_benchmark
+
+#include "../src/calc_manager_wrapper/utf8_transcode.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// The per-code-unit loop utf8_transcode.h replaced
+static std::string legacy_wstring_to_utf8(const std::wstring& wstr) {
+    if (wstr.empty()) return std::string();
+
+    std::string result;
+    result.reserve(wstr.size() * 3);
+
+    for (wchar_t wc : wstr) {
+        unsigned int code_point = static_cast<unsigned int>(wc);
+        if (code_point <= 0x7F) {
+            result.push_back(static_cast<char>(code_point));
+        } else if (code_point <= 0x7FF) {
+            result.push_back(static_cast<char>(0xC0 | ((code_point >> 6) & 0x1F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else if (code_point <= 0xFFFF) {
+            result.push_back(static_cast<char>(0xE0 | ((code_point >> 12) & 0x0F)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else {
+            result.push_back(static_cast<char>(0xF0 | ((code_point >> 18) & 0x07)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+    return result;
+}
+
+template <typename Function>
+static double measure_ns_per_call(const std::vector<std::wstring>& inputs, int iterations, Function transcode) {
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; n++) {
+        for (const auto& input : inputs) {
+            sink += transcode(input).size();
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (sink == 0) std::puts("");  // Keep the results observable
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(iterations) * inputs.size());
+}
+
+int main() {
+    const std::vector<std::wstring> inputs = {
+        L"0",
+        L"1,234,567.891",
+        L"-0.3333333333333333",
+        L"1.797693134862316e+308",
+        L"12 × ( 3 + 4 ) ÷ 5 = ",
+        L"√( 2 ) + sin₀( 30 ) - 1/( 7 ) ",
+        L"1111 1111 0000 1010 0101 1100 0011 1111 1111 1111 0000 1010 0101 1100 0011 1111",
+        L"[\"3.14159265358979\",\"2.71828182845904\",\"1.4142135623731\"]",
+    };
+
+    // Both implementations must agree on the BMP strings the engine produces
+    for (const auto& input : inputs) {
+        if (wstring_to_utf8(input) != legacy_wstring_to_utf8(input)) {
+            std::printf("Mismatch for input of length %zu\n", input.size());
+            return 1;
+        }
+        if (utf8_to_wstring(wstring_to_utf8(input)) != input) {
+            std::printf("Round trip failed for input of length %zu\n", input.size());
+            return 1;
+        }
+    }
+
+    // Lead bytes above 0xF4 are invalid; the continuation bytes after them decode separately
+    if (utf8_to_wstring("\xF8\x90\x80\x80") != std::wstring(4, L'\xFFFD')) {
+        std::printf("Lead byte 0xF8 was accepted\n");
+        return 1;
+    }
+
+    const int iterations = 200000;
+    double legacy = measure_ns_per_call(inputs, iterations, legacy_wstring_to_utf8);
+    double current = measure_ns_per_call(inputs, iterations, [](const std::wstring& s) { return wstring_to_utf8(s); });
+
+    std::printf("legacy loop       %8.1f ns/string\n", legacy);
+    std::printf("utf8_transcode.h  %8.1f ns/string\n", current);
+    std::printf("speedup           %8.2fx\n", legacy / current);
+    return 0;
+}
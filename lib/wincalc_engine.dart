@@ -9,12 +9,20 @@ import 'dart:ffi' as ffi;
 external int calc_cmd_binpos(int n);
 
 /// Lifecycle
+/// Threading: each instance must be used by one thread at a time, but different instances
+/// may be driven from different threads. CalcManager keeps Ratpack's constants and
+/// precision in process-wide state, so engine work is serialized internally. Display
+/// callbacks run on the calling thread after that internal lock is released, just before
+/// the call that raised them returns, so a callback never holds up other threads.
 @ffi.Native<ffi.Pointer<CalculatorInstance> Function()>()
 external ffi.Pointer<CalculatorInstance> calculator_create();
 
 @ffi.Native<ffi.Void Function(ffi.Pointer<CalculatorInstance>)>()
 external void calculator_destroy(ffi.Pointer<CalculatorInstance> instance);
 
+@ffi.Native<ffi.Void Function(ffi.Pointer<CalcLocale>)>()
+external void calculator_set_locale(ffi.Pointer<CalcLocale> locale);
+
 /// History load mode management
 @ffi.Native<ffi.Int Function(ffi.Pointer<CalculatorInstance>)>()
 external int calculator_is_in_history_load_mode(
@@ -57,6 +65,26 @@ external void calculator_send_command(
   int command,
 );
 
+/// Batched commands: applies `count` commands in a single call.
+/// Display callbacks are deferred while the batch runs. When it completes, discrete events
+/// (history item added, memory item changed, ...) are delivered in the order they occurred,
+/// then the final primary display, expression and parenthesis count are reported once.
+/// Returns the index of the first command that put the calculator into an error state
+/// (an error already present before the batch is not counted), `count` if no command
+/// did, or -1 on invalid arguments.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<CalculatorCommand>,
+    ffi.Int,
+  )
+>()
+external int calculator_send_commands(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<CalculatorCommand> commands,
+  int count,
+);
+
 /// Results
 @ffi.Native<
   ffi.Int Function(
@@ -87,6 +115,77 @@ external int calculator_get_expression(
 @ffi.Native<ffi.Int Function(ffi.Pointer<CalculatorInstance>)>()
 external int calculator_has_error(ffi.Pointer<CalculatorInstance> instance);
 
+/// Zero-copy access to the display state (UTF-8, NUL-terminated).
+/// The returned pointer is owned by the instance and stays valid until the next call
+/// that mutates the instance. `len` is optional and receives the length in bytes.
+/// Returns NULL if the instance is invalid.
+@ffi.Native<
+  ffi.Pointer<ffi.Char> Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<ffi.Int>,
+  )
+>()
+external ffi.Pointer<ffi.Char> calculator_peek_primary_display(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<ffi.Int> len,
+);
+
+@ffi.Native<
+  ffi.Pointer<ffi.Char> Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<ffi.Int>,
+  )
+>()
+external ffi.Pointer<ffi.Char> calculator_peek_expression(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<ffi.Int> len,
+);
+
+/// Returns 1 if the expression changed, 0 if not (diff is then empty at token_count), -1 on invalid arguments
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<CalcExpressionDiff>,
+  )
+>()
+external int calculator_get_expression_diff(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<CalcExpressionDiff> diff,
+);
+
+/// Fills up to `max` tokens and returns the total token count (call with max = 0 to size
+/// the array). All `text` slices point into one instance-owned buffer that stays valid
+/// until the next call that mutates the instance. Returns -1 on invalid arguments.
+@ffi.Native<
+  ffi.Int Function(ffi.Pointer<CalculatorInstance>, ffi.Pointer<CalcToken>, ffi.Int)
+>()
+external int calculator_get_expression_tokens(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<CalcToken> out,
+  int max,
+);
+
+@ffi.Native<ffi.Int Function(ffi.Pointer<CalculatorInstance>)>()
+external int calculator_get_expression_token_count(
+  ffi.Pointer<CalculatorInstance> instance,
+);
+
+/// Text of one token without the separating space; -1 if index is out of range
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Int,
+    ffi.Pointer<ffi.Char>,
+    ffi.Int,
+  )
+>()
+external int calculator_get_expression_token(
+  ffi.Pointer<CalculatorInstance> instance,
+  int index,
+  ffi.Pointer<ffi.Char> buffer,
+  int buffer_size,
+);
+
 /// State
 @ffi.Native<ffi.Void Function(ffi.Pointer<CalculatorInstance>, ffi.Int)>()
 external void calculator_reset(
@@ -169,7 +268,7 @@ external int calculator_get_result_bin(
   int buffer_size,
 );
 
-/// Binary representation for bit panel (64 chars: '0' or '1')
+/// Binary representation for bit panel (64 chars: '0' or '1', needs a 65-byte buffer)
 @ffi.Native<
   ffi.Int Function(
     ffi.Pointer<CalculatorInstance>,
@@ -183,6 +282,47 @@ external int calculator_get_binary_display(
   int buffer_size,
 );
 
+/// Fill `snapshot` from a single read of the current value. Returns 1 when the value was
+/// read as an integer, 0 when the strings had to be fetched per radix instead (not in
+/// programmer mode, or in an error state; `value` is then 0), -1 on invalid arguments,
+/// and -2 if any string did not fit its field (it is cut off but still NUL-terminated).
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<CalcRadixSnapshot>,
+  )
+>()
+external int calculator_get_all_radix_results(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<CalcRadixSnapshot> snapshot,
+);
+
+/// Current value as raw two's-complement bits (bit n = CMD_BINPOS(n)), plus the active
+/// word width in bits (8, 16, 32 or 64). Either output may be NULL. Returns 1 on success,
+/// 0 outside programmer mode or while the display shows an error.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<ffi.Uint64>,
+    ffi.Pointer<ffi.Int>,
+  )
+>()
+external int calculator_get_value_bits(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<ffi.Uint64> bits,
+  ffi.Pointer<ffi.Int> word_width,
+);
+
+/// Toggle every bit set in `mask` (bits beyond the word width are ignored) as one display
+/// update: the new value replaces the current entry as if typed in the current radix, and
+/// notifications are delivered once. Returns 1 on success, 0 outside programmer mode or
+/// while the display shows an error.
+@ffi.Native<ffi.Int Function(ffi.Pointer<CalculatorInstance>, ffi.Uint64)>()
+external int calculator_toggle_bits(
+  ffi.Pointer<CalculatorInstance> instance,
+  int mask,
+);
+
 /// Word size (for programmer mode)
 @ffi.Native<
   ffi.Void Function(ffi.Pointer<CalculatorInstance>, ffi.UnsignedInt)
@@ -434,7 +574,10 @@ int calculator_history_get_result_at_for_mode(
   buffer_size,
 );
 
-/// Set history items for current mode (used when switching back to a mode)
+/// Set history items for current mode (used when switching back to a mode).
+/// `json_data` is an array of {"expression": "...", "result": "..."} objects; items restored
+/// this way have no expression commands, so calculator_history_load_at ignores them.
+/// Malformed input leaves the history unchanged.
 @ffi.Native<
   ffi.Void Function(ffi.Pointer<CalculatorInstance>, ffi.Pointer<ffi.Char>)
 >()
@@ -443,6 +586,100 @@ external void calculator_history_set_from_vector(
   ffi.Pointer<ffi.Char> json_data,
 );
 
+/// Binary history serialization.
+/// calculator_history_save writes the history of `mode` (expressions, results, tokens and
+/// expression commands) as a versioned, length-prefixed blob and returns its size in bytes.
+/// Nothing is written unless buffer_size is at least that size; a NULL buffer is a size query.
+/// calculator_history_restore replaces the history of `mode` without replaying any commands
+/// and returns the number of items, -1 on invalid arguments or -2 on malformed data.
+/// Programmer mode shares the standard history.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.UnsignedInt,
+    ffi.Pointer<ffi.Void>,
+    ffi.Int,
+  )
+>(symbol: 'calculator_history_save')
+external int _calculator_history_save(
+  ffi.Pointer<CalculatorInstance> instance,
+  int mode,
+  ffi.Pointer<ffi.Void> buffer,
+  int buffer_size,
+);
+
+int calculator_history_save(
+  ffi.Pointer<CalculatorInstance> instance,
+  CalcMode mode,
+  ffi.Pointer<ffi.Void> buffer,
+  int buffer_size,
+) => _calculator_history_save(instance, mode.value, buffer, buffer_size);
+
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.UnsignedInt,
+    ffi.Pointer<ffi.Void>,
+    ffi.Int,
+  )
+>(symbol: 'calculator_history_restore')
+external int _calculator_history_restore(
+  ffi.Pointer<CalculatorInstance> instance,
+  int mode,
+  ffi.Pointer<ffi.Void> data,
+  int size,
+);
+
+int calculator_history_restore(
+  ffi.Pointer<CalculatorInstance> instance,
+  CalcMode mode,
+  ffi.Pointer<ffi.Void> data,
+  int size,
+) => _calculator_history_restore(instance, mode.value, data, size);
+
+/// Whole-instance snapshot.
+/// Captures mode, radix, word width, angle type, carry flag, history load mode, memory
+/// slots, the history of every mode, the pending expression (operands, operators and open
+/// parentheses) and the number being entered.
+/// calculator_snapshot: on entry *len is the capacity of `buf`, on return the snapshot size.
+/// Returns 0 when written, 1 when `buf` is NULL or too small (nothing is written), -1 on
+/// invalid arguments.
+/// calculator_restore: returns 0 on success, -1 on invalid arguments, -2 on malformed data
+/// (the instance is left untouched). History is restored as stored. The pending expression
+/// is rebuilt by replaying its commands; a finished equation is evaluated again, so its
+/// result keeps full precision and the next digit starts a new number. A number being typed
+/// is typed again and continues with the next digit. Memory slots are rebuilt at full
+/// precision from the values and finished equations stored into them with the
+/// calculator_memory_* functions; slots that were not tracked that way (and a value shown
+/// outside any expression, e.g. recalled from memory) are re-entered from their display
+/// strings and keep only display precision. An error state is restored with the same
+/// message, though not the expression that caused it.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<ffi.Void>,
+    ffi.Pointer<ffi.Size>,
+  )
+>()
+external int calculator_snapshot(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<ffi.Void> buf,
+  ffi.Pointer<ffi.Size> len,
+);
+
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorInstance>,
+    ffi.Pointer<ffi.Void>,
+    ffi.Size,
+  )
+>()
+external int calculator_restore(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<ffi.Void> buf,
+  int len,
+);
+
 /// Clear history for a specific mode
 @ffi.Native<
   ffi.Void Function(ffi.Pointer<CalculatorInstance>, ffi.UnsignedInt)
@@ -465,6 +702,37 @@ external int calculator_get_parenthesis_count(
   ffi.Pointer<CalculatorInstance> instance,
 );
 
+/// Evaluate an infix expression directly with the engine's Rational arithmetic,
+/// without simulating keystrokes or updating any calculator instance.
+/// Supported: decimal numbers (with optional e/E exponent), unary +/-, parentheses and
+/// binary + - * / (also UTF-8 × and ÷); scientific mode also accepts "mod", "^" and "yroot".
+/// Standard mode evaluates strictly left to right like the standard calculator;
+/// scientific mode applies operator precedence.
+/// Returns the length of the result written to `out`, -1 on invalid arguments,
+/// -2 on a syntax error, -3 on a math error (e.g. division by zero) and
+/// -4 if the mode is not supported.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<ffi.Char>,
+    ffi.UnsignedInt,
+    ffi.Pointer<ffi.Char>,
+    ffi.Int,
+  )
+>(symbol: 'calculator_evaluate')
+external int _calculator_evaluate(
+  ffi.Pointer<ffi.Char> expr,
+  int mode,
+  ffi.Pointer<ffi.Char> out,
+  int out_size,
+);
+
+int calculator_evaluate(
+  ffi.Pointer<ffi.Char> expr,
+  CalcMode mode,
+  ffi.Pointer<ffi.Char> out,
+  int out_size,
+) => _calculator_evaluate(expr, mode.value, out, out_size);
+
 /// Lifecycle
 @ffi.Native<ffi.Pointer<UnitConverterInstance> Function()>()
 external ffi.Pointer<UnitConverterInstance> unit_converter_create();
@@ -653,6 +921,47 @@ external int unit_converter_get_suggested_value(
   int unit_buffer_size,
 );
 
+/// Direct conversion against the shared unit catalog, without an instance, keystroke
+/// input or suggested values. Unit IDs are those returned by unit_converter_get_unit_id.
+/// `value` is a plain decimal number ("-12.5", "1e6"); the result is formatted like the
+/// converter's own "to" value (same rounding and trailing-zero trimming, scientific notation
+/// past 15 integer digits or below 1e-14). The catalog is process-wide, so no handle is
+/// taken. Returns the result length (see "String getters" above),
+/// -1 if the units are unknown or not convertible, -2 if `value` cannot be parsed.
+@ffi.Native<
+  ffi.Int Function(ffi.Int, ffi.Int, ffi.Pointer<ffi.Char>, ffi.Pointer<ffi.Char>, ffi.Int)
+>()
+external int unit_converter_convert(
+  int from_unit_id,
+  int to_unit_id,
+  ffi.Pointer<ffi.Char> value,
+  ffi.Pointer<ffi.Char> out,
+  int out_size,
+);
+
+/// Fast path of unit_converter_convert on doubles. Returns 1 on success, 0 otherwise.
+@ffi.Native<ffi.Int Function(ffi.Int, ffi.Int, ffi.Double, ffi.Pointer<ffi.Double>)>()
+external int unit_converter_convert_value(
+  int from_unit_id,
+  int to_unit_id,
+  double value,
+  ffi.Pointer<ffi.Double> out,
+);
+
+/// Convert `count` doubles from `in` into `out` (which may alias `in`) using a vectorized
+/// loop. Results are bit-identical to unit_converter_convert_value. Returns 1 on success,
+/// 0 if the units are unknown or not convertible.
+@ffi.Native<
+  ffi.Int Function(ffi.Int, ffi.Int, ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>, ffi.Size)
+>()
+external int unit_converter_convert_array(
+  int from_unit_id,
+  int to_unit_id,
+  ffi.Pointer<ffi.Double> in$,
+  ffi.Pointer<ffi.Double> out,
+  int count,
+);
+
 /// Set the user data pointer that will be passed to all callbacks
 @ffi.Native<
   ffi.Void Function(ffi.Pointer<CalculatorInstance>, ffi.Pointer<ffi.Void>)
@@ -795,6 +1104,104 @@ external void calculator_set_all_callbacks(
   ffi.Pointer<CalcDisplayCallbacks> callbacks,
 );
 
+/// Opt in to queued events: while enabled, display notifications are appended to a
+/// per-instance single-producer/single-consumer ring buffer instead of invoking callbacks.
+/// `capacity` is in bytes (rounded up to a power of two); 0 disables the queue.
+/// Must not be called concurrently with calculator_drain_events. Returns 1 on success.
+@ffi.Native<ffi.Int Function(ffi.Pointer<CalculatorInstance>, ffi.Int)>()
+external int calculator_enable_event_queue(
+  ffi.Pointer<CalculatorInstance> instance,
+  int capacity,
+);
+
+/// Copy as many complete event records as fit into `buffer` and return the bytes written
+/// (0 when the queue is empty). If the next record alone does not fit, nothing is copied
+/// and the negated size of that record is returned; a NULL buffer queries it the same way.
+/// May be called from a different thread than the one sending commands.
+@ffi.Native<
+  ffi.Int Function(ffi.Pointer<CalculatorInstance>, ffi.Pointer<ffi.Void>, ffi.Int)
+>()
+external int calculator_drain_events(
+  ffi.Pointer<CalculatorInstance> instance,
+  ffi.Pointer<ffi.Void> buffer,
+  int buffer_size,
+);
+
+/// Number of events dropped because the queue was full since the last call
+@ffi.Native<ffi.Int Function(ffi.Pointer<CalculatorInstance>)>()
+external int calculator_get_dropped_event_count(
+  ffi.Pointer<CalculatorInstance> instance,
+);
+
+/// Coalesce display notifications per command: while enabled, state notifications
+/// (primary display, error, expression, parenthesis, memorized numbers, input changed)
+/// are deferred while calculator_send_command runs and delivered at most once each,
+/// with the final value, when it returns. Discrete events are delivered immediately.
+@ffi.Native<ffi.Void Function(ffi.Pointer<CalculatorInstance>, ffi.Int)>()
+external void calculator_set_callback_coalescing(
+  ffi.Pointer<CalculatorInstance> instance,
+  int enabled,
+);
+
+/// Creates the pool with `initial_size` instances already built; NULL if initial_size < 0
+@ffi.Native<ffi.Pointer<CalculatorPool> Function(ffi.Int)>()
+external ffi.Pointer<CalculatorPool> calculator_pool_create(int initial_size);
+
+@ffi.Native<ffi.Void Function(ffi.Pointer<CalculatorPool>)>()
+external void calculator_pool_destroy(ffi.Pointer<CalculatorPool> pool);
+
+@ffi.Native<
+  ffi.Pointer<CalculatorInstance> Function(ffi.Pointer<CalculatorPool>)
+>()
+external ffi.Pointer<CalculatorInstance> calculator_pool_acquire(
+  ffi.Pointer<CalculatorPool> pool,
+);
+
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalculatorPool>,
+    ffi.Pointer<CalculatorInstance>,
+  )
+>()
+external int calculator_pool_release(
+  ffi.Pointer<CalculatorPool> pool,
+  ffi.Pointer<CalculatorInstance> instance,
+);
+
+@ffi.Native<
+  ffi.Void Function(ffi.Pointer<CalculatorPool>, ffi.Pointer<CalcPoolStats>)
+>()
+external void calculator_pool_get_stats(
+  ffi.Pointer<CalculatorPool> pool,
+  ffi.Pointer<CalcPoolStats> stats,
+);
+
+/// Evaluates `count` independent jobs on `threads` worker threads (<= 0 uses one per core,
+/// larger values are capped at the core count) and writes out[i] for jobs[i]. The calling
+/// thread is one of the workers. Workers claim jobs from their own share first, then steal
+/// from the others. Returns the number of successful jobs, or -1 on invalid arguments or a
+/// `count` above INT_MAX.
+/// Every job takes the engine lock described under Lifecycle, so jobs still run one at a
+/// time whatever the thread count. Throughput can only scale once Ratpack's global
+/// constants and precision are made per-engine in CalcManager.
+/// Worker threads and each worker's calculator per mode are created on first use and kept
+/// for later calls; concurrent calls run one after another. Command jobs start from a
+/// cleared calculator in their mode.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<CalcJob>,
+    ffi.Size,
+    ffi.Pointer<CalcResult>,
+    ffi.Int,
+  )
+>()
+external int calculator_evaluate_batch(
+  ffi.Pointer<CalcJob> jobs,
+  int count,
+  ffi.Pointer<CalcResult> out,
+  int threads,
+);
+
 /// ============================================================================
 /// Backward Compatibility (old function names)
 /// ============================================================================
@@ -832,6 +1239,8 @@ final class CalculatorInstance extends ffi.Opaque {}
 
 final class UnitConverterInstance extends ffi.Opaque {}
 
+final class CalculatorPool extends ffi.Opaque {}
+
 /// Calculator modes
 enum CalcMode {
   CALC_MODE_STANDARD(0),
@@ -1069,6 +1478,260 @@ final class CalcDisplayCallbacks extends ffi.Struct {
   external CalcDisplayInputChangedCallback onInputChanged;
 }
 
+/// Every programmer-panel representation of the current value, NUL-terminated and grouped
+/// like calculator_get_result_* (hex/bin in 4s, oct in 3s, dec with the locale's thousands
+/// separator and grouping pattern)
+final class CalcRadixSnapshot extends ffi.Struct {
+  /// Two's-complement value at the current word width
+  @ffi.Uint64()
+  external int value;
+
+  @ffi.Array.multi([24])
+  external ffi.Array<ffi.Char> hex;
+
+  @ffi.Array.multi([32])
+  external ffi.Array<ffi.Char> dec;
+
+  @ffi.Array.multi([32])
+  external ffi.Array<ffi.Char> oct;
+
+  @ffi.Array.multi([80])
+  external ffi.Array<ffi.Char> bin;
+
+  /// Same as calculator_get_binary_display
+  @ffi.Array.multi([65])
+  external ffi.Array<ffi.Char> bits;
+}
+
+/// Incremental expression display.
+/// The expression is a list of tokens; calculator_get_expression() joins them, each
+/// followed by a space. calculator_get_expression_diff() reports how the list changed
+/// since the previous diff call (or since creation): the `removed_count` tokens starting
+/// at `index` were replaced by the `inserted_count` tokens now at that index, so hosts
+/// can patch their rendering instead of rebuilding it.
+final class CalcExpressionDiff extends ffi.Struct {
+  @ffi.Int32()
+  external int index;
+
+  @ffi.Int32()
+  external int removed_count;
+
+  @ffi.Int32()
+  external int inserted_count;
+
+  /// Current number of tokens
+  @ffi.Int32()
+  external int token_count;
+}
+
+/// Pool of warm calculator instances for per-request use. Acquire hands out an idle
+/// instance (a hit) or creates one (a miss). Release resets it to the state
+/// calculator_create produces and keeps it for reuse. That state covers standard mode,
+/// cleared memory and history, default settings, and no callbacks, user data or event queue.
+/// Instances keep the locale that was current when they were created.
+/// Acquire and release may be called from any thread. Release every acquired instance
+/// before calculator_pool_destroy; instances that are never released must be freed with
+/// calculator_destroy.
+/// calculator_pool_release returns 0 when the instance was taken back, or -1 on invalid
+/// arguments or when `instance` is not currently acquired from this pool (created with
+/// calculator_create, acquired from another pool, or already released). A rejected
+/// instance is left untouched and stays owned by the caller.
+final class CalcPoolStats extends ffi.Struct {
+  /// Acquires served by an idle instance
+  @ffi.Uint64()
+  external int hits;
+
+  /// Acquires that created a new instance
+  @ffi.Uint64()
+  external int misses;
+
+  /// Instances waiting in the pool
+  @ffi.Uint64()
+  external int idle;
+
+  /// Instances acquired and not yet released
+  @ffi.Uint64()
+  external int in_use;
+}
+
+/// Locale pack: UTF-8 separators used by instances created afterwards.
+/// `grouping` uses the Windows LOCALE_SGROUPING form, e.g. "3;0" or "3;2;0".
+/// NULL fields (or a NULL locale) restore the defaults ".", "," and "3;0".
+/// Existing instances keep the locale they were created with.
+final class CalcLocale extends ffi.Struct {
+  external ffi.Pointer<ffi.Char> decimal_separator;
+
+  external ffi.Pointer<ffi.Char> grouping_separator;
+
+  external ffi.Pointer<ffi.Char> grouping;
+}
+
+/// Event types, one per ICalcDisplay notification
+enum CalcEventType {
+  /// value: isError, text: display string
+  CALC_EVENT_PRIMARY_DISPLAY(1),
+
+  /// value: isInError
+  CALC_EVENT_IS_IN_ERROR(2),
+
+  /// text: expression string
+  CALC_EVENT_EXPRESSION(3),
+
+  /// value: parenthesis count
+  CALC_EVENT_PARENTHESIS(4),
+  CALC_EVENT_NO_RIGHT_PAREN(5),
+  CALC_EVENT_MAX_DIGITS(6),
+  CALC_EVENT_BINARY_OPERATOR(7),
+
+  /// value: index of the added item
+  CALC_EVENT_HISTORY_ITEM_ADDED(8),
+
+  /// text: JSON array of memorized numbers
+  CALC_EVENT_MEMORIZED_NUMBERS(9),
+
+  /// value: memory slot index
+  CALC_EVENT_MEMORY_ITEM_CHANGED(10),
+  CALC_EVENT_INPUT_CHANGED(11);
+
+  final int value;
+  const CalcEventType(this.value);
+
+  static CalcEventType fromValue(int value) => switch (value) {
+    1 => CALC_EVENT_PRIMARY_DISPLAY,
+    2 => CALC_EVENT_IS_IN_ERROR,
+    3 => CALC_EVENT_EXPRESSION,
+    4 => CALC_EVENT_PARENTHESIS,
+    5 => CALC_EVENT_NO_RIGHT_PAREN,
+    6 => CALC_EVENT_MAX_DIGITS,
+    7 => CALC_EVENT_BINARY_OPERATOR,
+    8 => CALC_EVENT_HISTORY_ITEM_ADDED,
+    9 => CALC_EVENT_MEMORIZED_NUMBERS,
+    10 => CALC_EVENT_MEMORY_ITEM_CHANGED,
+    11 => CALC_EVENT_INPUT_CHANGED,
+    _ => throw ArgumentError('Unknown value for CalcEventType: $value'),
+  };
+}
+
+/// Header of each drained event record. Records are packed back to back: `size` is the
+/// total record size in bytes (8-byte aligned) and, for events with text, `text_length`
+/// bytes of NUL-terminated UTF-8 follow the header.
+final class CalcEventRecord extends ffi.Struct {
+  @ffi.Uint32()
+  external int type;
+
+  @ffi.Uint32()
+  external int value;
+
+  @ffi.Uint32()
+  external int size;
+
+  @ffi.Uint32()
+  external int text_length;
+}
+
+/// Structured expression tokens.
+/// Token kinds follow the engine's expression commands; CALC_TOKEN_TEXT covers tokens
+/// that were not rendered from a command.
+enum CalcTokenType {
+  /// command: the function, e.g. CMD_SIN
+  CALC_TOKEN_UNARY(0),
+
+  /// command: the operator, e.g. CMD_ADD
+  CALC_TOKEN_BINARY(1),
+
+  /// command: -1
+  CALC_TOKEN_OPERAND(2),
+
+  /// command: CMD_OPENP or CMD_CLOSEP
+  CALC_TOKEN_PARENTHESIS(3),
+
+  /// command: -1
+  CALC_TOKEN_TEXT(4);
+
+  final int value;
+  const CalcTokenType(this.value);
+
+  static CalcTokenType fromValue(int value) => switch (value) {
+    0 => CALC_TOKEN_UNARY,
+    1 => CALC_TOKEN_BINARY,
+    2 => CALC_TOKEN_OPERAND,
+    3 => CALC_TOKEN_PARENTHESIS,
+    4 => CALC_TOKEN_TEXT,
+    _ => throw ArgumentError('Unknown value for CalcTokenType: $value'),
+  };
+}
+
+final class CalcToken extends ffi.Struct {
+  /// CalcTokenType
+  @ffi.Int32()
+  external int type;
+
+  /// CalculatorCommand, or -1
+  @ffi.Int32()
+  external int command;
+
+  /// UTF-8, not NUL-terminated
+  external ffi.Pointer<ffi.Char> text;
+
+  /// Length of text in bytes
+  @ffi.Int32()
+  external int length;
+}
+
+/// ============================================================================
+/// Batch Evaluation
+/// ============================================================================
+enum CalcJobType {
+  /// Evaluate `expression` like calculator_evaluate
+  CALC_JOB_EXPRESSION(0),
+
+  /// Send `commands` to a fresh calculator in `mode`
+  CALC_JOB_COMMANDS(1);
+
+  final int value;
+  const CalcJobType(this.value);
+
+  static CalcJobType fromValue(int value) => switch (value) {
+    0 => CALC_JOB_EXPRESSION,
+    1 => CALC_JOB_COMMANDS,
+    _ => throw ArgumentError('Unknown value for CalcJobType: $value'),
+  };
+}
+
+final class CalcJob extends ffi.Struct {
+  /// CalcJobType
+  @ffi.Int32()
+  external int type;
+
+  /// CalcMode
+  @ffi.Int32()
+  external int mode;
+
+  /// CALC_JOB_EXPRESSION: UTF-8, NUL-terminated
+  external ffi.Pointer<ffi.Char> expression;
+
+  /// CALC_JOB_COMMANDS
+  external ffi.Pointer<CalculatorCommand> commands;
+
+  @ffi.Int32()
+  external int command_count;
+}
+
+final class CalcResult extends ffi.Struct {
+  /// 0 on success. Expression jobs: the negative calculator_evaluate error code.
+  /// Command jobs: 1 if the display ended in an error state. -1 for an invalid job.
+  @ffi.Int32()
+  external int status;
+
+  /// Full UTF-8 length of the result; >= sizeof(text) means truncated
+  @ffi.Int32()
+  external int length;
+
+  /// Result or final primary display, NUL-terminated
+  @ffi.Array.multi([64])
+  external ffi.Array<ffi.Char> text;
+}
+
 const int CMD_0 = 130;
 
 const int CMD_1 = 131;
@@ -3,254 +3,502 @@
 // Copyright (c) 2024. MIT License.
 
 #include "calc_manager_wrapper.h"
-
+#include "utf8_transcode.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <codecvt>
 #include <locale>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
 // CalcManager headers
 #include <CalculatorManager.h>
 #include <CalculatorResource.h>
 #include <EngineStrings.h>
+#include <ExpressionCommand.h>
 #include <ExpressionCommandInterface.h>
 #include <ICalcDisplay.h>
 #include <UnitConverter.h>
 #include "Header Files/CCommand.h"  // For IDC_EQU
+#include "Header Files/RationalMath.h"
 
 // ============================================================================
-// Helper: Wide string to UTF-8 conversion
+// Helper: Copy UTF-8 into caller buffers
 // ============================================================================
 
-static std::string wstring_to_utf8(const std::wstring& wstr) {
-    if (wstr.empty()) return std::string();
-
-    std::string result;
-    result.reserve(wstr.size() * 3);
-
-    for (wchar_t wc : wstr) {
-        // Promote to int to avoid shift warnings on Windows where wchar_t is 16-bit
-        unsigned int code_point = static_cast<unsigned int>(wc);
-        if (code_point <= 0x7F) {
-            result.push_back(static_cast<char>(code_point));
-        } else if (code_point <= 0x7FF) {
-            result.push_back(static_cast<char>(0xC0 | ((code_point >> 6) & 0x1F)));
-            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
-        } else if (code_point <= 0xFFFF) {
-            result.push_back(static_cast<char>(0xE0 | ((code_point >> 12) & 0x0F)));
-            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
-            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
-         } else {
-            result.push_back(static_cast<char>(0xF0 | ((code_point >> 18) & 0x07)));
-            result.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
-            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
-            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
-        }
-    }
-    return result;
-}
-
-static int copy_to_buffer(const std::string& str, char* buffer, int buffer_size) {
-    if (!buffer || buffer_size <= 0) return -1;
-
+// snprintf-like copy: always returns the full length of `str`.
+// A NULL buffer only queries the length; a result >= buffer_size means truncation.
+static int copy_to_buffer(std::string_view str, char* buffer, int buffer_size) {
     int len = static_cast<int>(str.length());
+    if (!buffer || buffer_size <= 0) return len;
+
     if (len >= buffer_size) {
         // Buffer too small, copy what we can
-        std::memcpy(buffer, str.c_str(), buffer_size - 1);
+        std::memcpy(buffer, str.data(), buffer_size - 1);
         buffer[buffer_size - 1] = '\0';
-        return buffer_size - 1;
+        return len;
     }
 
-    std::memcpy(buffer, str.c_str(), len + 1);
+    std::memcpy(buffer, str.data(), len);
+    buffer[len] = '\0';
     return len;
 }
 
+// ============================================================================
+// Engine Lock
+// ============================================================================
+
+// Ratpack keeps its radix- and precision-dependent constants (pi, e, ln 2, trig limits)
+// and the working precision in process globals that every CCalcEngine rebuilds when it
+// changes mode, radix or precision. Those globals live in CalcManager, so engine work from
+// any instance runs under one process-wide lock. Display callbacks raised under the lock
+// are held per thread and delivered once the outermost EngineLock has released it, so a
+// slow host callback never blocks other threads. The lock is still recursive, since the
+// wrapper's own exports call each other while holding it.
+static std::recursive_mutex g_engineMutex;
+static thread_local int t_engineLockDepth = 0;
+
+static void deliver_deferred_callbacks();
+
+class EngineLock {
+public:
+    EngineLock() {
+        g_engineMutex.lock();
+        t_engineLockDepth++;
+    }
+
+    ~EngineLock() {
+        bool outermost = --t_engineLockDepth == 0;
+        g_engineMutex.unlock();
+        if (outermost) deliver_deferred_callbacks();
+    }
+
+    EngineLock(const EngineLock&) = delete;
+    EngineLock& operator=(const EngineLock&) = delete;
+};
+
 // ============================================================================
 // Resource Provider Implementation
 // ============================================================================
 
+// Process-wide locale pack. Instances capture the current pack when they are created,
+// since the engine reads the separators once while it is constructed.
+struct LocalePack {
+    std::wstring decimal = L".";
+    std::wstring thousand = L",";
+    std::wstring grouping = L"3;0";
+};
+
+static std::mutex g_localeMutex;
+static std::shared_ptr<const LocalePack> g_locale = std::make_shared<const LocalePack>();
+
+static std::shared_ptr<const LocalePack> current_locale() {
+    std::lock_guard<std::mutex> lock(g_localeMutex);
+    return g_locale;
+}
+
+struct EngineStringEntry {
+    std::wstring_view id;
+    std::wstring_view value;
+};
+
+// Engine strings, in any order; sorted by id at compile time below
+static constexpr EngineStringEntry ENGINE_STRING_TABLE[] = {
+    {SIDS_PLUS_MINUS, L"\u00B1"},
+    {SIDS_CLEAR, L"C"},
+    {SIDS_CE, L"CE"},
+    {SIDS_BACKSPACE, L"\u232B"},
+    {SIDS_DECIMAL_SEPARATOR, L"."},
+    {SIDS_EMPTY_STRING, L""},
+    {SIDS_AND, L"AND"},
+    {SIDS_OR, L"OR"},
+    {SIDS_XOR, L"XOR"},
+    {SIDS_LSH, L"Lsh"},
+    {SIDS_RSH, L"Rsh"},
+    {SIDS_DIVIDE, L"\u00F7"},
+    {SIDS_MULTIPLY, L"\u00D7"},
+    {SIDS_PLUS, L"+"},
+    {SIDS_MINUS, L"-"},
+    {SIDS_MOD, L"Mod"},
+    {SIDS_YROOT, L"yroot"},
+    {SIDS_POW_HAT, L"^"},
+    {SIDS_INT, L"int"},
+    {SIDS_ROL, L"rol"},
+    {SIDS_ROR, L"ror"},
+    {SIDS_NOT, L"NOT"},
+    {SIDS_SIN, L"sin"},
+    {SIDS_COS, L"cos"},
+    {SIDS_TAN, L"tan"},
+    {SIDS_SINH, L"sinh"},
+    {SIDS_COSH, L"cosh"},
+    {SIDS_TANH, L"tanh"},
+    {SIDS_LN, L"ln"},
+    {SIDS_LOG, L"log"},
+    {SIDS_SQRT, L"\u221A"},
+    {SIDS_XPOW2, L"sqr"},
+    {SIDS_XPOW3, L"cube"},
+    {SIDS_NFACTORIAL, L"fact"},
+    {SIDS_FACT, L"fact"},
+    {SIDS_RECIPROCAL, L"1/"},
+    {SIDS_RECIPROC, L"1/"},
+    {SIDS_DMS, L"dms"},
+    {SIDS_DEGREES, L"degrees"},
+    {SIDS_CUBEROOT, L"\u221B"},
+    {SIDS_SQR, L"sqr"},
+    {SIDS_CUBE, L"cube"},
+    {SIDS_CUBERT, L"\u221B"},
+    {SIDS_POWTEN, L"10^"},
+    {SIDS_PERCENT, L"%"},
+    {SIDS_SCIENTIFIC_NOTATION, L"e"},
+    {SIDS_PI, L"\u03C0"},
+    {SIDS_EQUAL, L"="},
+    {SIDS_MC, L"MC"},
+    {SIDS_MR, L"MR"},
+    {SIDS_MS, L"MS"},
+    {SIDS_MPLUS, L"M+"},
+    {SIDS_MMINUS, L"M-"},
+    {SIDS_EXP, L"exp"},
+    {SIDS_OPEN_PAREN, L"("},
+    {SIDS_CLOSE_PAREN, L")"},
+    {SIDS_0, L"0"},
+    {SIDS_1, L"1"},
+    {SIDS_2, L"2"},
+    {SIDS_3, L"3"},
+    {SIDS_4, L"4"},
+    {SIDS_5, L"5"},
+    {SIDS_6, L"6"},
+    {SIDS_7, L"7"},
+    {SIDS_8, L"8"},
+    {SIDS_9, L"9"},
+    {SIDS_A, L"A"},
+    {SIDS_B, L"B"},
+    {SIDS_C, L"C"},
+    {SIDS_D, L"D"},
+    {SIDS_E, L"E"},
+    {SIDS_F, L"F"},
+    {SIDS_FRAC, L"frac"},
+    {SIDS_NEGATE, L"negate"},
+    {SIDS_DIVIDEBYZERO, L"Cannot divide by zero"},
+    {SIDS_DOMAIN, L"Invalid input"},
+    {SIDS_UNDEFINED, L"Result is undefined"},
+    {SIDS_POS_INFINITY, L"Positive infinity"},
+    {SIDS_NEG_INFINITY, L"Negative infinity"},
+    {SIDS_ABORTED, L"Aborted"},
+    {SIDS_NOMEM, L"Out of memory"},
+    {SIDS_TOOMANY, L"Too many"},
+    {SIDS_OVERFLOW, L"Overflow"},
+    {SIDS_NORESULT, L"No result"},
+    {SIDS_INSUFFICIENT_DATA, L"Insufficient data"},
+    // Trig functions by angle mode
+    {SIDS_SIND, L"sin"},
+    {SIDS_COSD, L"cos"},
+    {SIDS_TAND, L"tan"},
+    {SIDS_ASIND, L"asin"},
+    {SIDS_ACOSD, L"acos"},
+    {SIDS_ATAND, L"atan"},
+    {SIDS_SINR, L"sin"},
+    {SIDS_COSR, L"cos"},
+    {SIDS_TANR, L"tan"},
+    {SIDS_ASINR, L"asin"},
+    {SIDS_ACOSR, L"acos"},
+    {SIDS_ATANR, L"atan"},
+    {SIDS_SING, L"sin"},
+    {SIDS_COSG, L"cos"},
+    {SIDS_TANG, L"tan"},
+    {SIDS_ASING, L"asin"},
+    {SIDS_ACOSG, L"acos"},
+    {SIDS_ATANG, L"atan"},
+    // Hyperbolic
+    {SIDS_ASINH, L"asinh"},
+    {SIDS_ACOSH, L"acosh"},
+    {SIDS_ATANH, L"atanh"},
+    {SIDS_POWE, L"e^"},
+    {SIDS_TWOPOWX, L"2^"},
+    {SIDS_ABS, L"abs"},
+    {SIDS_FLOOR, L"floor"},
+    {SIDS_CEIL, L"ceil"},
+    {SIDS_NAND, L"NAND"},
+    {SIDS_NOR, L"NOR"},
+    // Sec, Csc, Cot by angle mode
+    {SIDS_SECD, L"sec"},
+    {SIDS_ASECD, L"asec"},
+    {SIDS_CSCD, L"csc"},
+    {SIDS_ACSCD, L"acsc"},
+    {SIDS_COTD, L"cot"},
+    {SIDS_ACOTD, L"acot"},
+    {SIDS_SECR, L"sec"},
+    {SIDS_ASECR, L"asec"},
+    {SIDS_CSCR, L"csc"},
+    {SIDS_ACSCR, L"acsc"},
+    {SIDS_COTR, L"cot"},
+    {SIDS_ACOTR, L"acot"},
+    {SIDS_SECG, L"sec"},
+    {SIDS_ASECG, L"asec"},
+    {SIDS_CSCG, L"csc"},
+    {SIDS_ACSCG, L"acsc"},
+    {SIDS_COTG, L"cot"},
+    {SIDS_ACOTG, L"acot"},
+    {SIDS_SECH, L"sech"},
+    {SIDS_ASECH, L"asech"},
+    {SIDS_CSCH, L"csch"},
+    {SIDS_ACSCH, L"acsch"},
+    {SIDS_COTH, L"coth"},
+    {SIDS_ACOTH, L"acoth"},
+    {SIDS_LOGBASEY, L"log"},
+};
+
+// Stable insertion sort, so for a repeated id the first entry listed wins
+template <size_t N>
+static constexpr std::array<EngineStringEntry, N> sort_engine_strings(const EngineStringEntry (&table)[N]) {
+    std::array<EngineStringEntry, N> entries{};
+    for (size_t i = 0; i < N; i++) {
+        size_t j = i;
+        while (j > 0 && table[i].id < entries[j - 1].id) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = table[i];
+    }
+    return entries;
+}
+
+static constexpr auto ENGINE_STRINGS = sort_engine_strings(ENGINE_STRING_TABLE);
+
+static std::wstring_view find_engine_string(std::wstring_view id) {
+    auto it = std::lower_bound(ENGINE_STRINGS.begin(), ENGINE_STRINGS.end(), id,
+        [](const EngineStringEntry& entry, std::wstring_view key) { return entry.id < key; });
+    if (it != ENGINE_STRINGS.end() && it->id == id) {
+        return it->value;
+    }
+    return {};
+}
+
 class ResourceProviderImpl : public CalculationManager::IResourceProvider {
 public:
+    ResourceProviderImpl() : m_locale(current_locale()) {}
+
+    // IResourceProvider returns std::wstring, so one copy per call remains; the lookup
+    // itself is a binary search over static data
     std::wstring GetCEngineString(std::wstring_view id) override {
         // Locale-specific strings
-        if (id == L"sDecimal") return L".";
-        if (id == L"sThousand") return L",";
-        if (id == L"sGrouping") return L"3;0";
-
-        // Engine strings mapping
-        static const std::unordered_map<std::wstring_view, std::wstring> engineStrings = {
-            {SIDS_PLUS_MINUS, L"\u00B1"},
-            {SIDS_CLEAR, L"C"},
-            {SIDS_CE, L"CE"},
-            {SIDS_BACKSPACE, L"\u232B"},
-            {SIDS_DECIMAL_SEPARATOR, L"."},
-            {SIDS_EMPTY_STRING, L""},
-            {SIDS_AND, L"AND"},
-            {SIDS_OR, L"OR"},
-            {SIDS_XOR, L"XOR"},
-            {SIDS_LSH, L"Lsh"},
-            {SIDS_RSH, L"Rsh"},
-            {SIDS_DIVIDE, L"\u00F7"},
-            {SIDS_MULTIPLY, L"\u00D7"},
-            {SIDS_PLUS, L"+"},
-            {SIDS_MINUS, L"-"},
-            {SIDS_MOD, L"Mod"},
-            {SIDS_YROOT, L"yroot"},
-            {SIDS_POW_HAT, L"^"},
-            {SIDS_INT, L"int"},
-            {SIDS_ROL, L"rol"},
-            {SIDS_ROR, L"ror"},
-            {SIDS_NOT, L"NOT"},
-            {SIDS_SIN, L"sin"},
-            {SIDS_COS, L"cos"},
-            {SIDS_TAN, L"tan"},
-            {SIDS_SINH, L"sinh"},
-            {SIDS_COSH, L"cosh"},
-            {SIDS_TANH, L"tanh"},
-            {SIDS_LN, L"ln"},
-            {SIDS_LOG, L"log"},
-            {SIDS_SQRT, L"\u221A"},
-            {SIDS_XPOW2, L"sqr"},
-            {SIDS_XPOW3, L"cube"},
-            {SIDS_NFACTORIAL, L"fact"},
-            {SIDS_FACT, L"fact"},
-            {SIDS_RECIPROCAL, L"1/"},
-            {SIDS_RECIPROC, L"1/"},
-            {SIDS_DMS, L"dms"},
-            {SIDS_DEGREES, L"degrees"},
-            {SIDS_CUBEROOT, L"\u221B"},
-            {SIDS_SQR, L"sqr"},
-            {SIDS_CUBE, L"cube"},
-            {SIDS_CUBERT, L"\u221B"},
-            {SIDS_POWTEN, L"10^"},
-            {SIDS_PERCENT, L"%"},
-            {SIDS_SCIENTIFIC_NOTATION, L"e"},
-            {SIDS_PI, L"\u03C0"},
-            {SIDS_EQUAL, L"="},
-            {SIDS_MC, L"MC"},
-            {SIDS_MR, L"MR"},
-            {SIDS_MS, L"MS"},
-            {SIDS_MPLUS, L"M+"},
-            {SIDS_MMINUS, L"M-"},
-            {SIDS_EXP, L"exp"},
-            {SIDS_OPEN_PAREN, L"("},
-            {SIDS_CLOSE_PAREN, L")"},
-            {SIDS_0, L"0"},
-            {SIDS_1, L"1"},
-            {SIDS_2, L"2"},
-            {SIDS_3, L"3"},
-            {SIDS_4, L"4"},
-            {SIDS_5, L"5"},
-            {SIDS_6, L"6"},
-            {SIDS_7, L"7"},
-            {SIDS_8, L"8"},
-            {SIDS_9, L"9"},
-            {SIDS_A, L"A"},
-            {SIDS_B, L"B"},
-            {SIDS_C, L"C"},
-            {SIDS_D, L"D"},
-            {SIDS_E, L"E"},
-            {SIDS_F, L"F"},
-            {SIDS_FRAC, L"frac"},
-            {SIDS_NEGATE, L"negate"},
-            {SIDS_DIVIDEBYZERO, L"Cannot divide by zero"},
-            {SIDS_DOMAIN, L"Invalid input"},
-            {SIDS_UNDEFINED, L"Result is undefined"},
-            {SIDS_POS_INFINITY, L"Positive infinity"},
-            {SIDS_NEG_INFINITY, L"Negative infinity"},
-            {SIDS_ABORTED, L"Aborted"},
-            {SIDS_NOMEM, L"Out of memory"},
-            {SIDS_TOOMANY, L"Too many"},
-            {SIDS_OVERFLOW, L"Overflow"},
-            {SIDS_NORESULT, L"No result"},
-            {SIDS_INSUFFICIENT_DATA, L"Insufficient data"},
-            // Trig functions by angle mode
-            {SIDS_SIND, L"sin"},
-            {SIDS_COSD, L"cos"},
-            {SIDS_TAND, L"tan"},
-            {SIDS_ASIND, L"asin"},
-            {SIDS_ACOSD, L"acos"},
-            {SIDS_ATAND, L"atan"},
-            {SIDS_SINR, L"sin"},
-            {SIDS_COSR, L"cos"},
-            {SIDS_TANR, L"tan"},
-            {SIDS_ASINR, L"asin"},
-            {SIDS_ACOSR, L"acos"},
-            {SIDS_ATANR, L"atan"},
-            {SIDS_SING, L"sin"},
-            {SIDS_COSG, L"cos"},
-            {SIDS_TANG, L"tan"},
-            {SIDS_ASING, L"asin"},
-            {SIDS_ACOSG, L"acos"},
-            {SIDS_ATANG, L"atan"},
-            // Hyperbolic
-            {SIDS_ASINH, L"asinh"},
-            {SIDS_ACOSH, L"acosh"},
-            {SIDS_ATANH, L"atanh"},
-            {SIDS_POWE, L"e^"},
-            {SIDS_TWOPOWX, L"2^"},
-            {SIDS_ABS, L"abs"},
-            {SIDS_FLOOR, L"floor"},
-            {SIDS_CEIL, L"ceil"},
-            {SIDS_NAND, L"NAND"},
-            {SIDS_NOR, L"NOR"},
-            // Sec, Csc, Cot by angle mode
-            {SIDS_SECD, L"sec"},
-            {SIDS_ASECD, L"asec"},
-            {SIDS_CSCD, L"csc"},
-            {SIDS_ACSCD, L"acsc"},
-            {SIDS_COTD, L"cot"},
-            {SIDS_ACOTD, L"acot"},
-            {SIDS_SECR, L"sec"},
-            {SIDS_ASECR, L"asec"},
-            {SIDS_CSCR, L"csc"},
-            {SIDS_ACSCR, L"acsc"},
-            {SIDS_COTR, L"cot"},
-            {SIDS_ACOTR, L"acot"},
-            {SIDS_SECG, L"sec"},
-            {SIDS_ASECG, L"asec"},
-            {SIDS_CSCG, L"csc"},
-            {SIDS_ACSCG, L"acsc"},
-            {SIDS_COTG, L"cot"},
-            {SIDS_ACOTG, L"acot"},
-            {SIDS_SECH, L"sech"},
-            {SIDS_ASECH, L"asech"},
-            {SIDS_CSCH, L"csch"},
-            {SIDS_ACSCH, L"acsch"},
-            {SIDS_COTH, L"coth"},
-            {SIDS_ACOTH, L"acoth"},
-            {SIDS_LOGBASEY, L"log"},
-        };
-
-        auto it = engineStrings.find(id);
-        if (it != engineStrings.end()) {
-            return it->second;
-        }
+        if (id == L"sDecimal" || id == SIDS_DECIMAL_SEPARATOR) return m_locale->decimal;
+        if (id == L"sThousand") return m_locale->thousand;
+        if (id == L"sGrouping") return m_locale->grouping;
+
+        return std::wstring(find_engine_string(id));
+    }
 
-        return L"";
+    const LocalePack& Locale() const {
+        return *m_locale;
     }
+
+private:
+    std::shared_ptr<const LocalePack> m_locale;
 };
 
 struct CalculatorInstance;
 
+// ============================================================================
+// Display Event Queue (single-producer/single-consumer ring buffer)
+// ============================================================================
+
+static constexpr size_t EVENT_QUEUE_MIN_CAPACITY = 256;
+static constexpr size_t EVENT_QUEUE_MAX_CAPACITY = 1 << 24;
+static constexpr size_t EVENT_RECORD_ALIGNMENT = 8;
+
+// Records are a CalcEventRecord header followed by NUL-terminated UTF-8 text, padded
+// to 8 bytes. Positions grow monotonically and are masked into the buffer, so a record
+// may wrap around the end; the producer owns m_tail and the consumer owns m_head.
+class EventQueue {
+public:
+    explicit EventQueue(size_t capacity) : m_buffer(capacity), m_mask(capacity - 1) {}
+
+    // Producer side. Returns false (and counts a drop) if the record does not fit.
+    bool Push(uint32_t type, uint32_t value, const std::string* text) {
+        uint32_t textLength = text ? static_cast<uint32_t>(text->length()) : 0;
+        size_t size = sizeof(CalcEventRecord) + (text ? textLength + 1 : 0);
+        size = (size + EVENT_RECORD_ALIGNMENT - 1) & ~(EVENT_RECORD_ALIGNMENT - 1);
+
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        if (size > m_buffer.size() - (tail - head)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        CalcEventRecord record = {type, value, static_cast<uint32_t>(size), textLength};
+        Write(tail, &record, sizeof(record));
+        if (text) {
+            Write(tail + sizeof(record), text->c_str(), textLength + 1);
+        }
+
+        m_tail.store(tail + size, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Copies whole records while they fit and returns the bytes written.
+    // When the next record alone is larger than outSize, nothing is copied and its size
+    // is stored in `required`; otherwise `required` is 0.
+    size_t Drain(char* out, size_t outSize, size_t& required) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t written = 0;
+        required = 0;
+
+        while (head < tail) {
+            CalcEventRecord record;
+            Read(head, &record, sizeof(record));
+            if (written + record.size > outSize) {
+                if (written == 0) required = record.size;
+                break;
+            }
+
+            Read(head, out + written, record.size);
+            written += record.size;
+            head += record.size;
+        }
+
+        m_head.store(head, std::memory_order_release);
+        return written;
+    }
+
+    uint32_t TakeDroppedCount() {
+        return m_dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<char> m_buffer;
+    size_t m_mask;
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
+    std::atomic<uint32_t> m_dropped{0};
+
+    void Write(size_t pos, const void* data, size_t length) {
+        size_t offset = pos & m_mask;
+        size_t first = std::min(length, m_buffer.size() - offset);
+        std::memcpy(m_buffer.data() + offset, data, first);
+        std::memcpy(m_buffer.data(), static_cast<const char*>(data) + first, length - first);
+    }
+
+    void Read(size_t pos, void* data, size_t length) const {
+        size_t offset = pos & m_mask;
+        size_t first = std::min(length, m_buffer.size() - offset);
+        std::memcpy(data, m_buffer.data() + offset, first);
+        std::memcpy(static_cast<char*>(data) + first, m_buffer.data(), length - first);
+    }
+};
+
 // ============================================================================
 // Calculator Display Implementation with Callbacks
 // ============================================================================
 
+// One token of the expression display with its cached UTF-8 fragment
+struct ExpressionToken {
+    std::wstring text;
+    std::string utf8;  // text followed by the separating space
+    int commandIndex = -1;
+    CalcTokenType type = CALC_TOKEN_TEXT;
+    int32_t command = -1;
+};
+
+using ExpressionCommandList = std::vector<std::shared_ptr<IExpressionCommand>>;
+
+// Classify a token by the expression command it was rendered from
+static void resolve_token_command(ExpressionToken& token, int commandIndex, const ExpressionCommandList* commands) {
+    token.commandIndex = commandIndex;
+    token.type = CALC_TOKEN_TEXT;
+    token.command = -1;
+    if (!commands || commandIndex < 0 || static_cast<size_t>(commandIndex) >= commands->size()) return;
+
+    const IExpressionCommand* command = (*commands)[commandIndex].get();
+    if (!command) return;
+
+    switch (command->GetCommandType()) {
+        case CalculationManager::CommandType::UnaryCommand: {
+            // Inverse functions are stored as two commands; the last one is the function
+            const auto& list = static_cast<const IUnaryCommand*>(command)->GetCommands();
+            token.type = CALC_TOKEN_UNARY;
+            if (list && !list->empty()) token.command = list->back();
+            break;
+        }
+        case CalculationManager::CommandType::BinaryCommand:
+            token.type = CALC_TOKEN_BINARY;
+            token.command = static_cast<const IBinaryCommand*>(command)->GetCommand();
+            break;
+        case CalculationManager::CommandType::OperandCommand:
+            token.type = CALC_TOKEN_OPERAND;
+            break;
+        case CalculationManager::CommandType::Parentheses:
+            token.type = CALC_TOKEN_PARENTHESIS;
+            token.command = static_cast<const IParenthesisCommand*>(command)->GetCommand();
+            break;
+        default:
+            break;
+    }
+}
+
 class CalcDisplayImpl : public ICalcDisplay {
 public:
     std::wstring primaryDisplay;
-    std::wstring expression;
+    std::vector<ExpressionToken> expressionTokens;
+    std::shared_ptr<ExpressionCommandList> expressionCommands;  // The engine's live list for the pending expression
     bool hasError = false;
     unsigned int parenthesisCount = 0;
     std::vector<std::wstring> memorizedNumbers;
 
+    // Set by apply_command while the engine is taking digits for the shown number, so the
+    // next digit extends it; any other display change clears it
+    bool numberEntry = false;
+
+    // Whether the expression display holds a finished equation: the engine publishes
+    // the tokens ending in "=" and keeps them until the next expression starts
+    bool ExpressionComplete() const {
+        return !expressionTokens.empty() && expressionTokens.back().commandIndex < 0 &&
+               expressionTokens.back().text == L"=";
+    }
+
+    // Coalescing state: while updateDepth > 0, state notifications only mark a bit in
+    // pendingEvents and the current value of each marked field is delivered once by EndUpdate
+    int updateDepth = 0;
+    uint32_t pendingEvents = 0;
+
+    // While set, discrete events are queued in arrival order and delivered by EndUpdate
+    // ahead of the coalesced state notifications
+    bool deferDiscreteEvents = false;
+    std::vector<std::pair<CalcEventType, uint32_t>> pendingDiscreteEvents;
+
     // Callback pointers and user data
     CalculatorInstance* parentInstance = nullptr;
 
+    // UTF-8 forms of the display strings, converted on first read after a change
+    const std::string& PrimaryDisplayUtf8();
+    const std::string& ExpressionUtf8() const;
+
+    // Token-level change since the previous call; returns false if nothing changed
+    bool TakeExpressionDiff(CalcExpressionDiff& diff);
+
     // Method declarations - implementations are after CalculatorInstance definition
     void SetPrimaryDisplay(const std::wstring& displayString, bool isError) override;
     void SetIsInError(bool isInError) override;
@@ -265,12 +513,57 @@ public:
     void SetMemorizedNumbers(const std::vector<std::wstring>& memorizedNums) override;
     void MemoryItemChanged(unsigned int indexOfMemory) override;
     void InputChanged() override;
+
+    // Whether anyone (event queue or callback) is listening for this notification
+    bool HasListener(CalcEventType type) const;
+
+    // Route a notification to the event queue when enabled, otherwise to its callback
+    void Notify(CalcEventType type, uint32_t value = 0, const std::string* text = nullptr);
+
+    // Open/close a coalescing scope; the outermost EndUpdate flushes pending notifications
+    void BeginUpdate();
+    void EndUpdate();
+
+private:
+    std::string m_primaryDisplayUtf8;
+    std::string m_expressionUtf8;
+    bool m_primaryDisplayUtf8Stale = false;
+
+    // Pending expression diff, as the number of leading and trailing tokens that are
+    // unchanged relative to the token list of length m_diffBaseCount
+    bool m_expressionDiffPending = false;
+    size_t m_diffPrefix = 0;
+    size_t m_diffSuffix = 0;
+    size_t m_diffBaseCount = 0;
+
+    // Classification of the incoming tokens, reused across SetExpressionDisplay calls
+    std::vector<ExpressionToken> m_incomingTokens;
+
+    // State notifications (display, error, expression, parenthesis, memory list, input)
+    // are fully described by the current field values, so they can be deferred and
+    // coalesced; discrete events go straight to Notify unless a batch defers them
+    void NotifyState(CalcEventType type);
+    void NotifyDiscrete(CalcEventType type, uint32_t value = 0);
 };
 
 // ============================================================================
 // Calculator Instance Structure
 // ============================================================================
 
+enum class MemoryOperation : uint8_t { Store, Add, Subtract };
+
+// One MS, M+ or M- applied to a memory slot, kept so the slot can be rebuilt at full
+// precision: the engine's memory values are private and only published as display strings
+struct MemoryTerm {
+    MemoryOperation operation = MemoryOperation::Store;
+    CalcMode mode = CALC_MODE_STANDARD;                 // Engine that evaluates `expression`
+    std::shared_ptr<ExpressionCommandList> expression;  // Finished equation whose result was used
+    std::wstring value;                                 // Otherwise the number, in decimal
+};
+
+// Past this many terms a slot is no longer tracked and falls back to its display string
+static constexpr size_t MAX_MEMORY_TERMS = 256;
+
 struct CalculatorInstance {
     std::unique_ptr<CalculationManager::CalculatorManager> manager;
     std::unique_ptr<ResourceProviderImpl> resourceProvider;
@@ -281,6 +574,15 @@ struct CalculatorInstance {
     CalcWordType currentWordType = CALC_WORD_QWORD;
     uint64_t carryFlag = 0;
     bool isInHistoryLoadMode = false;  // Track history item load mode
+    bool suppressCallbacks = false;    // Set while a snapshot is being replayed
+    bool coalesceCallbacks = false;    // Deliver one notification per changed field per command
+
+    // Terms of each memory slot, newest slot first like memorizedNumbers; an empty list is
+    // a slot that is not tracked. Only meaningful while its size matches memorizedNumbers.
+    std::vector<std::vector<MemoryTerm>> memoryTerms;
+
+    // Opt-in queue that replaces synchronous callbacks while enabled
+    std::unique_ptr<EventQueue> eventQueue;
 
     // Callback user data
     void* callbackUserData = nullptr;
@@ -299,102 +601,350 @@ struct CalculatorInstance {
     CalcDisplayInputChangedCallback onInputChanged = nullptr;
 };
 
+bool CalcDisplayImpl::HasListener(CalcEventType type) const {
+    if (!parentInstance || parentInstance->suppressCallbacks) return false;
+    if (parentInstance->eventQueue) return true;
+
+    switch (type) {
+        case CALC_EVENT_PRIMARY_DISPLAY:      return parentInstance->onSetPrimaryDisplay != nullptr;
+        case CALC_EVENT_IS_IN_ERROR:          return parentInstance->onSetIsInError != nullptr;
+        case CALC_EVENT_EXPRESSION:           return parentInstance->onSetExpression != nullptr;
+        case CALC_EVENT_PARENTHESIS:          return parentInstance->onSetParenthesis != nullptr;
+        case CALC_EVENT_NO_RIGHT_PAREN:       return parentInstance->onNoRightParenAdded != nullptr;
+        case CALC_EVENT_MAX_DIGITS:           return parentInstance->onMaxDigitsReached != nullptr;
+        case CALC_EVENT_BINARY_OPERATOR:      return parentInstance->onBinaryOperatorReceived != nullptr;
+        case CALC_EVENT_HISTORY_ITEM_ADDED:   return parentInstance->onHistoryItemAdded != nullptr;
+        case CALC_EVENT_MEMORIZED_NUMBERS:    return parentInstance->onSetMemorizedNumbers != nullptr;
+        case CALC_EVENT_MEMORY_ITEM_CHANGED:  return parentInstance->onMemoryItemChanged != nullptr;
+        case CALC_EVENT_INPUT_CHANGED:        return parentInstance->onInputChanged != nullptr;
+        default:                              return false;
+    }
+}
+
+// Callbacks raised while this thread holds the engine lock, in the order they were raised.
+// `instance` is cleared if the instance is destroyed before delivery.
+struct DeferredCallback {
+    CalculatorInstance* instance;
+    CalcEventType type;
+    uint32_t value;
+    std::string text;
+};
+
+static thread_local std::vector<DeferredCallback> t_deferredCallbacks;
+static thread_local bool t_deliveringCallbacks = false;
+
+static void invoke_callback(CalculatorInstance* instance, CalcEventType type, uint32_t value, const char* text) {
+    void* userData = instance->callbackUserData;
+    switch (type) {
+        case CALC_EVENT_PRIMARY_DISPLAY:
+            if (instance->onSetPrimaryDisplay) instance->onSetPrimaryDisplay(text, static_cast<int>(value), userData);
+            break;
+        case CALC_EVENT_IS_IN_ERROR:
+            if (instance->onSetIsInError) instance->onSetIsInError(static_cast<int>(value), userData);
+            break;
+        case CALC_EVENT_EXPRESSION:
+            if (instance->onSetExpression) instance->onSetExpression(text, userData);
+            break;
+        case CALC_EVENT_PARENTHESIS:
+            if (instance->onSetParenthesis) instance->onSetParenthesis(value, userData);
+            break;
+        case CALC_EVENT_NO_RIGHT_PAREN:
+            if (instance->onNoRightParenAdded) instance->onNoRightParenAdded(userData);
+            break;
+        case CALC_EVENT_MAX_DIGITS:
+            if (instance->onMaxDigitsReached) instance->onMaxDigitsReached(userData);
+            break;
+        case CALC_EVENT_BINARY_OPERATOR:
+            if (instance->onBinaryOperatorReceived) instance->onBinaryOperatorReceived(userData);
+            break;
+        case CALC_EVENT_HISTORY_ITEM_ADDED:
+            if (instance->onHistoryItemAdded) instance->onHistoryItemAdded(value, userData);
+            break;
+        case CALC_EVENT_MEMORIZED_NUMBERS:
+            if (instance->onSetMemorizedNumbers) instance->onSetMemorizedNumbers(text, userData);
+            break;
+        case CALC_EVENT_MEMORY_ITEM_CHANGED:
+            if (instance->onMemoryItemChanged) instance->onMemoryItemChanged(value, userData);
+            break;
+        case CALC_EVENT_INPUT_CHANGED:
+            if (instance->onInputChanged) instance->onInputChanged(userData);
+            break;
+    }
+}
+
+// Runs after the outermost EngineLock is released. Callbacks may call back into the
+// wrapper; whatever those calls raise is appended and delivered by this same loop, so
+// callbacks still arrive in the order the engine raised them.
+static void deliver_deferred_callbacks() {
+    if (t_deliveringCallbacks) return;
+
+    t_deliveringCallbacks = true;
+    for (size_t i = 0; i < t_deferredCallbacks.size(); i++) {
+        // Moved out because a callback may append and reallocate the list
+        DeferredCallback callback = std::move(t_deferredCallbacks[i]);
+        if (callback.instance) {
+            invoke_callback(callback.instance, callback.type, callback.value, callback.text.c_str());
+        }
+    }
+    t_deferredCallbacks.clear();
+    t_deliveringCallbacks = false;
+}
+
+// Drop undelivered callbacks for an instance that is being destroyed
+static void discard_deferred_callbacks(CalculatorInstance* instance) {
+    for (DeferredCallback& callback : t_deferredCallbacks) {
+        if (callback.instance == instance) callback.instance = nullptr;
+    }
+}
+
+void CalcDisplayImpl::Notify(CalcEventType type, uint32_t value, const std::string* text) {
+    if (!HasListener(type)) return;
+
+    CalculatorInstance* instance = parentInstance;
+    if (instance->eventQueue) {
+        instance->eventQueue->Push(static_cast<uint32_t>(type), value, text);
+        return;
+    }
+
+    if (t_engineLockDepth > 0) {
+        t_deferredCallbacks.push_back({instance, type, value, text ? *text : std::string()});
+        return;
+    }
+    invoke_callback(instance, type, value, text ? text->c_str() : nullptr);
+}
+
+const std::string& CalcDisplayImpl::PrimaryDisplayUtf8() {
+    if (m_primaryDisplayUtf8Stale) {
+        m_primaryDisplayUtf8 = wstring_to_utf8(primaryDisplay);
+        m_primaryDisplayUtf8Stale = false;
+    }
+    return m_primaryDisplayUtf8;
+}
+
+const std::string& CalcDisplayImpl::ExpressionUtf8() const {
+    return m_expressionUtf8;
+}
+
+bool CalcDisplayImpl::TakeExpressionDiff(CalcExpressionDiff& diff) {
+    const size_t count = expressionTokens.size();
+    diff.token_count = static_cast<int32_t>(count);
+    if (!m_expressionDiffPending) {
+        diff.index = static_cast<int32_t>(count);
+        diff.removed_count = 0;
+        diff.inserted_count = 0;
+        return false;
+    }
+
+    diff.index = static_cast<int32_t>(m_diffPrefix);
+    diff.removed_count = static_cast<int32_t>(m_diffBaseCount - m_diffPrefix - m_diffSuffix);
+    diff.inserted_count = static_cast<int32_t>(count - m_diffPrefix - m_diffSuffix);
+    m_expressionDiffPending = false;
+    return true;
+}
+
+void CalcDisplayImpl::BeginUpdate() {
+    updateDepth++;
+}
+
+void CalcDisplayImpl::EndUpdate() {
+    if (updateDepth == 0 || --updateDepth > 0) return;
+
+    // Flush in a fixed order so hosts see the error state before the display text
+    static constexpr CalcEventType flushOrder[] = {
+        CALC_EVENT_IS_IN_ERROR, CALC_EVENT_PRIMARY_DISPLAY, CALC_EVENT_EXPRESSION,
+        CALC_EVENT_PARENTHESIS, CALC_EVENT_MEMORIZED_NUMBERS, CALC_EVENT_INPUT_CHANGED,
+    };
+
+    std::vector<std::pair<CalcEventType, uint32_t>> discrete;
+    discrete.swap(pendingDiscreteEvents);
+    for (const auto& [type, value] : discrete) {
+        Notify(type, value);
+    }
+
+    uint32_t pending = pendingEvents;
+    pendingEvents = 0;
+    for (CalcEventType type : flushOrder) {
+        if (pending & (1u << type)) {
+            NotifyState(type);
+        }
+    }
+}
+
+void CalcDisplayImpl::NotifyState(CalcEventType type) {
+    if (updateDepth > 0) {
+        pendingEvents |= 1u << type;
+        return;
+    }
+    if (!HasListener(type)) return;
+
+    switch (type) {
+        case CALC_EVENT_PRIMARY_DISPLAY:
+            Notify(type, hasError ? 1 : 0, &PrimaryDisplayUtf8());
+            break;
+        case CALC_EVENT_IS_IN_ERROR:
+            Notify(type, hasError ? 1 : 0);
+            break;
+        case CALC_EVENT_EXPRESSION:
+            Notify(type, 0, &ExpressionUtf8());
+            break;
+        case CALC_EVENT_PARENTHESIS:
+            Notify(type, parenthesisCount);
+            break;
+        case CALC_EVENT_MEMORIZED_NUMBERS: {
+            // Notify listeners with the numbers as a JSON array
+            std::string json = "[";
+            for (size_t i = 0; i < memorizedNumbers.size(); i++) {
+                if (i > 0) json += ",";
+                json += '"';
+                append_utf8(json, memorizedNumbers[i]);
+                json += '"';
+            }
+            json += "]";
+            Notify(type, 0, &json);
+            break;
+        }
+        default:
+            Notify(type);
+            break;
+    }
+}
+
+void CalcDisplayImpl::NotifyDiscrete(CalcEventType type, uint32_t value) {
+    if (deferDiscreteEvents) {
+        if (HasListener(type)) pendingDiscreteEvents.emplace_back(type, value);
+        return;
+    }
+    Notify(type, value);
+}
+
 void CalcDisplayImpl::SetPrimaryDisplay(const std::wstring& displayString, bool isError) {
     primaryDisplay = displayString;
+    m_primaryDisplayUtf8Stale = true;
     hasError = isError;
+    numberEntry = false;
 
-    // Invoke callback if registered
-    if (parentInstance && parentInstance->onSetPrimaryDisplay) {
-        std::string utf8 = wstring_to_utf8(displayString);
-        parentInstance->onSetPrimaryDisplay(utf8.c_str(), isError ? 1 : 0, parentInstance->callbackUserData);
-    }
+    NotifyState(CALC_EVENT_PRIMARY_DISPLAY);
 }
 
 void CalcDisplayImpl::SetIsInError(bool isInError) {
     hasError = isInError;
 
-    // Invoke callback if registered
-    if (parentInstance && parentInstance->onSetIsInError) {
-        parentInstance->onSetIsInError(isInError ? 1 : 0, parentInstance->callbackUserData);
-    }
+    NotifyState(CALC_EVENT_IS_IN_ERROR);
 }
 
 void CalcDisplayImpl::SetExpressionDisplay(
     _Inout_ std::shared_ptr<std::vector<std::pair<std::wstring, int>>> const& tokens,
-    _Inout_ std::shared_ptr<std::vector<std::shared_ptr<IExpressionCommand>>> const& /*commands*/) {
-    expression.clear();
-    if (tokens) {
-        for (const auto& token : *tokens) {
-            expression += token.first;
-            expression += L" ";
+    _Inout_ std::shared_ptr<std::vector<std::shared_ptr<IExpressionCommand>>> const& commands) {
+    expressionCommands = commands;
+
+    static const std::vector<std::pair<std::wstring, int>> noTokens;
+    const auto& next = tokens ? *tokens : noTokens;
+    const size_t oldCount = expressionTokens.size();
+    const size_t newCount = next.size();
+
+    // Classify the incoming tokens first: a token is only unchanged if its text, kind
+    // and command all match, since the same text can come from different commands
+    m_incomingTokens.resize(newCount);
+    for (size_t i = 0; i < newCount; i++) {
+        resolve_token_command(m_incomingTokens[i], next[i].second, commands.get());
+    }
+    auto unchanged = [&](size_t oldIndex, size_t newIndex) {
+        const ExpressionToken& current = expressionTokens[oldIndex];
+        const ExpressionToken& incoming = m_incomingTokens[newIndex];
+        return current.type == incoming.type && current.command == incoming.command &&
+               current.text == next[newIndex].first;
+    };
+
+    // The engine resends the whole token list on every change, but usually only the tail
+    // differs: keep the unchanged prefix and suffix and re-encode just the tokens between
+    size_t prefix = 0;
+    while (prefix < oldCount && prefix < newCount && unchanged(prefix, prefix)) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < oldCount - prefix && suffix < newCount - prefix &&
+           unchanged(oldCount - 1 - suffix, newCount - 1 - suffix)) {
+        suffix++;
+    }
+
+    if (prefix + suffix != oldCount || oldCount != newCount) {
+        size_t removedBytes = 0;
+        size_t suffixBytes = 0;
+        for (size_t i = prefix; i < oldCount; i++) {
+            (i < oldCount - suffix ? removedBytes : suffixBytes) += expressionTokens[i].utf8.size();
+        }
+
+        std::vector<ExpressionToken> inserted;
+        inserted.reserve(newCount - prefix - suffix);
+        std::string insertedUtf8;
+        for (size_t i = prefix; i < newCount - suffix; i++) {
+            ExpressionToken token = m_incomingTokens[i];
+            token.text = next[i].first;
+            token.utf8 = wstring_to_utf8(next[i].first);
+            token.utf8 += ' ';
+            insertedUtf8 += token.utf8;
+            inserted.push_back(std::move(token));
+        }
+
+        m_expressionUtf8.replace(m_expressionUtf8.size() - suffixBytes - removedBytes, removedBytes, insertedUtf8);
+        expressionTokens.erase(expressionTokens.begin() + prefix, expressionTokens.begin() + (oldCount - suffix));
+        expressionTokens.insert(expressionTokens.begin() + prefix,
+            std::make_move_iterator(inserted.begin()), std::make_move_iterator(inserted.end()));
+
+        // Widen the pending diff so it still describes the change from the last state the host read
+        if (!m_expressionDiffPending) {
+            m_expressionDiffPending = true;
+            m_diffPrefix = prefix;
+            m_diffSuffix = suffix;
+            m_diffBaseCount = oldCount;
+        } else {
+            m_diffPrefix = std::min(m_diffPrefix, prefix);
+            m_diffSuffix = std::min(m_diffSuffix, suffix);
         }
     }
 
-    // Invoke callback if registered
-    if (parentInstance && parentInstance->onSetExpression) {
-        std::string utf8 = wstring_to_utf8(expression);
-        parentInstance->onSetExpression(utf8.c_str(), parentInstance->callbackUserData);
+    // Retained suffix tokens move when tokens are inserted or removed before them
+    for (size_t i = newCount - suffix; i < newCount; i++) {
+        expressionTokens[i].commandIndex = next[i].second;
     }
+
+    NotifyState(CALC_EVENT_EXPRESSION);
 }
 
 void CalcDisplayImpl::SetParenthesisNumber(unsigned int count) {
     parenthesisCount = count;
 
-    // Invoke callback if registered
-    if (parentInstance && parentInstance->onSetParenthesis) {
-        parentInstance->onSetParenthesis(count, parentInstance->callbackUserData);
-    }
+    NotifyState(CALC_EVENT_PARENTHESIS);
 }
 
 void CalcDisplayImpl::OnNoRightParenAdded() {
-    if (parentInstance && parentInstance->onNoRightParenAdded) {
-        parentInstance->onNoRightParenAdded(parentInstance->callbackUserData);
-    }
+    NotifyDiscrete(CALC_EVENT_NO_RIGHT_PAREN);
 }
 
 void CalcDisplayImpl::MaxDigitsReached() {
-    if (parentInstance && parentInstance->onMaxDigitsReached) {
-        parentInstance->onMaxDigitsReached(parentInstance->callbackUserData);
-    }
+    NotifyDiscrete(CALC_EVENT_MAX_DIGITS);
 }
 
 void CalcDisplayImpl::BinaryOperatorReceived() {
-    if (parentInstance && parentInstance->onBinaryOperatorReceived) {
-        parentInstance->onBinaryOperatorReceived(parentInstance->callbackUserData);
-    }
+    NotifyDiscrete(CALC_EVENT_BINARY_OPERATOR);
 }
 
 void CalcDisplayImpl::OnHistoryItemAdded(unsigned int addedItemIndex) {
-    if (parentInstance && parentInstance->onHistoryItemAdded) {
-        parentInstance->onHistoryItemAdded(addedItemIndex, parentInstance->callbackUserData);
-    }
+    NotifyDiscrete(CALC_EVENT_HISTORY_ITEM_ADDED, addedItemIndex);
 }
 
 void CalcDisplayImpl::SetMemorizedNumbers(const std::vector<std::wstring>& memorizedNums) {
     memorizedNumbers = memorizedNums;
 
-    // Invoke callback if registered (send as JSON array)
-    if (parentInstance && parentInstance->onSetMemorizedNumbers) {
-        std::string json = "[";
-        for (size_t i = 0; i < memorizedNums.size(); i++) {
-            if (i > 0) json += ",";
-            json += "\"" + wstring_to_utf8(memorizedNums[i]) + "\"";
-        }
-        json += "]";
-        parentInstance->onSetMemorizedNumbers(json.c_str(), parentInstance->callbackUserData);
-    }
+    NotifyState(CALC_EVENT_MEMORIZED_NUMBERS);
 }
 
 void CalcDisplayImpl::MemoryItemChanged(unsigned int indexOfMemory) {
-    if (parentInstance && parentInstance->onMemoryItemChanged) {
-        parentInstance->onMemoryItemChanged(indexOfMemory, parentInstance->callbackUserData);
-    }
+    NotifyDiscrete(CALC_EVENT_MEMORY_ITEM_CHANGED, indexOfMemory);
 }
 
 void CalcDisplayImpl::InputChanged() {
-    if (parentInstance && parentInstance->onInputChanged) {
-        parentInstance->onInputChanged(parentInstance->callbackUserData);
-    }
+    NotifyState(CALC_EVENT_INPUT_CHANGED);
 }
 
 // ============================================================================
@@ -402,6 +952,7 @@ void CalcDisplayImpl::InputChanged() {
 // ============================================================================
 
 CalculatorInstance* calculator_create(void) {
+    EngineLock lock;
     auto instance = new CalculatorInstance();
     instance->resourceProvider = std::make_unique<ResourceProviderImpl>();
     instance->display = std::make_unique<CalcDisplayImpl>();
@@ -414,10 +965,25 @@ CalculatorInstance* calculator_create(void) {
 }
 
 void calculator_destroy(CalculatorInstance* instance) {
+    EngineLock lock;
+    discard_deferred_callbacks(instance);
     delete instance;
 }
 
+void calculator_set_locale(const CalcLocale* locale) {
+    auto pack = std::make_shared<LocalePack>();
+    if (locale) {
+        if (locale->decimal_separator) pack->decimal = utf8_to_wstring(locale->decimal_separator);
+        if (locale->grouping_separator) pack->thousand = utf8_to_wstring(locale->grouping_separator);
+        if (locale->grouping) pack->grouping = utf8_to_wstring(locale->grouping);
+    }
+
+    std::lock_guard<std::mutex> lock(g_localeMutex);
+    g_locale = std::move(pack);
+}
+
 void calculator_set_standard_mode(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->SetStandardMode();
         instance->currentMode = CALC_MODE_STANDARD;
@@ -425,6 +991,7 @@ void calculator_set_standard_mode(CalculatorInstance* instance) {
 }
 
 void calculator_set_scientific_mode(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->SetScientificMode();
         instance->currentMode = CALC_MODE_SCIENTIFIC;
@@ -432,6 +999,7 @@ void calculator_set_scientific_mode(CalculatorInstance* instance) {
 }
 
 void calculator_set_programmer_mode(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->SetProgrammerMode();
         instance->currentMode = CALC_MODE_PROGRAMMER;
@@ -445,9 +1013,21 @@ int calculator_get_current_mode(CalculatorInstance* instance) {
     return CALC_MODE_STANDARD;
 }
 
-void calculator_send_command(CalculatorInstance* instance, CalculatorCommand command) {
-    if (!instance || !instance->manager) return;
+// Whether `command` leaves the engine taking digits for the shown number. Digits valid in
+// the radix and the decimal point start or extend an entry; the exponent, backspace and
+// (in decimal) +/- edit the entry in progress; everything else ends it.
+static bool continues_number_entry(const CalculatorInstance* instance, CalculatorCommand command, bool wasEntering) {
+    int radix = instance->currentMode == CALC_MODE_PROGRAMMER ? instance->currentRadix : 10;
+    if (command >= CMD_0 && command <= CMD_F) return command - CMD_0 < radix;
+    if (command == CMD_DECIMAL) return radix == 10;
+    if (command == CMD_EXP || command == CMD_BACKSPACE) return wasEntering;
+    if (command == CMD_NEGATE) return wasEntering && radix == 10;
+    return false;
+}
 
+// Track state that the wrapper mirrors (word width, angle type, number entry) and forward
+// the command
+static void apply_command(CalculatorInstance* instance, CalculatorCommand command) {
     // If we're in history load mode, just clear the flag and continue normally
     // Don't try to recreate the deleted history entry as it may cause display issues
     if (instance->isInHistoryLoadMode) {
@@ -481,21 +1061,125 @@ void calculator_send_command(CalculatorInstance* instance, CalculatorCommand com
             break;
     }
 
+    CalcDisplayImpl* display = instance->display.get();
+    bool wasEntering = display && display->numberEntry;
     instance->manager->SendCommand(static_cast<CalculationManager::Command>(command));
+    if (display) {
+        display->numberEntry = !display->hasError && continues_number_entry(instance, command, wasEntering);
+    }
+}
+
+void calculator_send_command(CalculatorInstance* instance, CalculatorCommand command) {
+    if (!instance || !instance->manager) return;
+
+    EngineLock lock;
+
+    if (instance->coalesceCallbacks && instance->display) {
+        instance->display->BeginUpdate();
+        apply_command(instance, command);
+        instance->display->EndUpdate();
+    } else {
+        apply_command(instance, command);
+    }
+}
+
+int calculator_send_commands(CalculatorInstance* instance, const CalculatorCommand* commands, int count) {
+    if (!instance || !instance->manager || !instance->display || count < 0) return -1;
+    if (!commands && count > 0) return -1;
+
+    EngineLock lock;
+
+    int firstError = count;
+    CalcDisplayImpl* display = instance->display.get();
+
+    // Discrete events are queued for the batch; state changes are coalesced and the
+    // final value of each changed field is reported once when the scope closes
+    display->BeginUpdate();
+    display->deferDiscreteEvents = true;
+    bool wasInError = display->hasError;
+    for (int i = 0; i < count; i++) {
+        apply_command(instance, commands[i]);
+        // An error carried in from before the batch is not attributed to its commands
+        if (firstError == count && display->hasError && !wasInError) {
+            firstError = i;
+        }
+        wasInError = display->hasError;
+    }
+    display->deferDiscreteEvents = false;
+    display->EndUpdate();
+
+    return firstError;
 }
 
 int calculator_get_primary_display(CalculatorInstance* instance, char* buffer, int buffer_size) {
     if (!instance || !instance->display) return -1;
 
-    std::string utf8 = wstring_to_utf8(instance->display->primaryDisplay);
-    return copy_to_buffer(utf8, buffer, buffer_size);
+    return copy_to_buffer(instance->display->PrimaryDisplayUtf8(), buffer, buffer_size);
 }
 
 int calculator_get_expression(CalculatorInstance* instance, char* buffer, int buffer_size) {
     if (!instance || !instance->display) return -1;
 
-    std::string utf8 = wstring_to_utf8(instance->display->expression);
-    return copy_to_buffer(utf8, buffer, buffer_size);
+    return copy_to_buffer(instance->display->ExpressionUtf8(), buffer, buffer_size);
+}
+
+const char* calculator_peek_primary_display(CalculatorInstance* instance, int* len) {
+    if (!instance || !instance->display) return nullptr;
+
+    const std::string& utf8 = instance->display->PrimaryDisplayUtf8();
+    if (len) *len = static_cast<int>(utf8.length());
+    return utf8.c_str();
+}
+
+const char* calculator_peek_expression(CalculatorInstance* instance, int* len) {
+    if (!instance || !instance->display) return nullptr;
+
+    const std::string& utf8 = instance->display->ExpressionUtf8();
+    if (len) *len = static_cast<int>(utf8.length());
+    return utf8.c_str();
+}
+
+int calculator_get_expression_diff(CalculatorInstance* instance, CalcExpressionDiff* diff) {
+    if (!instance || !instance->display || !diff) return -1;
+
+    return instance->display->TakeExpressionDiff(*diff) ? 1 : 0;
+}
+
+int calculator_get_expression_tokens(CalculatorInstance* instance, CalcToken* out, int max) {
+    if (!instance || !instance->display || (!out && max > 0)) return -1;
+
+    const auto& tokens = instance->display->expressionTokens;
+    const size_t count = std::min(tokens.size(), static_cast<size_t>(std::max(max, 0)));
+
+    // The joined expression string is the arena: each token's slice stops before its space
+    const char* arena = instance->display->ExpressionUtf8().data();
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        const ExpressionToken& token = tokens[i];
+        out[i].type = token.type;
+        out[i].command = token.command;
+        out[i].text = arena + offset;
+        out[i].length = static_cast<int32_t>(token.utf8.size() - 1);
+        offset += token.utf8.size();
+    }
+    return static_cast<int>(tokens.size());
+}
+
+int calculator_get_expression_token_count(CalculatorInstance* instance) {
+    if (!instance || !instance->display) return -1;
+
+    return static_cast<int>(instance->display->expressionTokens.size());
+}
+
+int calculator_get_expression_token(CalculatorInstance* instance, int index, char* buffer, int buffer_size) {
+    if (!instance || !instance->display) return -1;
+
+    const auto& tokens = instance->display->expressionTokens;
+    if (index < 0 || static_cast<size_t>(index) >= tokens.size()) return -1;
+
+    // Drop the separating space kept at the end of each fragment
+    const std::string& utf8 = tokens[index].utf8;
+    return copy_to_buffer(std::string_view(utf8).substr(0, utf8.size() - 1), buffer, buffer_size);
 }
 
 int calculator_has_error(CalculatorInstance* instance) {
@@ -506,12 +1190,15 @@ int calculator_has_error(CalculatorInstance* instance) {
 }
 
 void calculator_reset(CalculatorInstance* instance, int clear_memory) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->Reset(clear_memory != 0);
+        if (clear_memory) instance->memoryTerms.clear();
     }
 }
 
 int calculator_is_input_empty(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         return instance->manager->IsInputEmpty() ? 1 : 0;
     }
@@ -525,6 +1212,8 @@ int calculator_is_input_empty(CalculatorInstance* instance) {
 void calculator_set_radix(CalculatorInstance* instance, CalcRadixType radix) {
     if (!instance || !instance->manager) return;
 
+    EngineLock lock;
+
     ::RadixType engineRadix;
     switch (radix) {
         case CALC_RADIX_HEX:     engineRadix = ::RadixType::Hex; break;
@@ -548,6 +1237,8 @@ int calculator_get_radix(CalculatorInstance* instance) {
 static int get_result_for_radix(CalculatorInstance* instance, uint32_t radix, char* buffer, int buffer_size) {
     if (!instance || !instance->manager) return -1;
 
+    EngineLock lock;
+
     std::wstring result = instance->manager->GetResultForRadix(radix, 64, true);
     std::string utf8 = wstring_to_utf8(result);
     return copy_to_buffer(utf8, buffer, buffer_size);
@@ -570,7 +1261,9 @@ int calculator_get_result_bin(CalculatorInstance* instance, char* buffer, int bu
 }
 
 int calculator_get_binary_display(CalculatorInstance* instance, char* buffer, int buffer_size) {
-    if (!instance || !instance->manager || buffer_size < 65) return -1;
+    if (!instance || !instance->manager) return -1;
+
+    EngineLock lock;
 
     std::wstring binResult = instance->manager->GetResultForRadix(2, 64, false);
 
@@ -598,18 +1291,238 @@ int calculator_get_binary_display(CalculatorInstance* instance, char* buffer, in
     return copy_to_buffer(result, buffer, buffer_size);
 }
 
-// ============================================================================
-// Word Size Functions (for Programmer Mode)
-// ============================================================================
+static int word_width_bits(NUM_WIDTH width) {
+    switch (width) {
+        case NUM_WIDTH::DWORD_WIDTH: return 32;
+        case NUM_WIDTH::WORD_WIDTH:  return 16;
+        case NUM_WIDTH::BYTE_WIDTH:  return 8;
+        default:                     return 64;
+    }
+}
 
-void calculator_set_word_width(CalculatorInstance* instance, CalcWordType word_type) {
-    if (!instance || !instance->manager) return;
+// Read the current programmer-mode value as raw bits with one engine conversion.
+// Fails outside programmer mode or when the display holds an error.
+static bool read_programmer_value(CalculatorInstance* instance, uint64_t* value) {
+    if (instance->currentMode != CALC_MODE_PROGRAMMER || !instance->display || instance->display->hasError) {
+        return false;
+    }
 
-    CalculationManager::Command cmd;
-    switch (word_type) {
-        case CALC_WORD_QWORD: cmd = CalculationManager::Command::CommandQword; break;
-        case CALC_WORD_DWORD: cmd = CalculationManager::Command::CommandDword; break;
-        case CALC_WORD_WORD:  cmd = CalculationManager::Command::CommandWord; break;
+    // Ungrouped hex is already masked to the word width in two's complement
+    std::wstring hex = instance->manager->GetResultForRadix(16, 64, false);
+    if (hex.empty() || hex.length() > 16) return false;
+
+    uint64_t bits = 0;
+    for (wchar_t c : hex) {
+        int digit;
+        if (c >= L'0' && c <= L'9') digit = c - L'0';
+        else if (c >= L'A' && c <= L'F') digit = c - L'A' + 10;
+        else if (c >= L'a' && c <= L'f') digit = c - L'a' + 10;
+        else return false;
+        bits = (bits << 4) | static_cast<uint64_t>(digit);
+    }
+
+    *value = bits;
+    return true;
+}
+
+// Format `value` in a power-of-two radix, grouping digits from the right
+static std::string format_grouped(uint64_t value, int bitsPerDigit, int groupSize) {
+    static constexpr char digits[] = "0123456789ABCDEF";
+    const uint64_t mask = (uint64_t{1} << bitsPerDigit) - 1;
+
+    char text[96];
+    char* p = text + sizeof(text);
+    int count = 0;
+    do {
+        if (count > 0 && count % groupSize == 0) *--p = ' ';
+        *--p = digits[value & mask];
+        value >>= bitsPerDigit;
+        count++;
+    } while (value != 0);
+
+    return std::string(p, text + sizeof(text));
+}
+
+// Group sizes from a locale grouping pattern such as "3;0" or "3;2;0"
+static std::vector<uint32_t> parse_grouping(std::wstring_view pattern) {
+    std::vector<uint32_t> grouping;
+    uint32_t group = 0;
+    bool hasDigits = false;
+    for (wchar_t c : pattern) {
+        if (c >= L'0' && c <= L'9') {
+            group = group * 10 + static_cast<uint32_t>(c - L'0');
+            hasDigits = true;
+        } else if (c == L';') {
+            if (hasDigits) grouping.push_back(group);
+            group = 0;
+            hasDigits = false;
+        }
+    }
+    if (hasDigits) grouping.push_back(group);
+    return grouping;
+}
+
+// Signed decimal at the given word width, grouped like CCalcEngine::GroupDigits: each
+// entry of `grouping` sizes the next group from the right, a trailing 0 repeats the
+// previous size, and without one grouping stops after the listed groups
+static std::string format_signed_decimal(uint64_t value, int widthBits, const std::string& separator,
+                                         const std::vector<uint32_t>& grouping) {
+    bool negative = widthBits < 64 ? (value >> (widthBits - 1)) & 1 : (value >> 63) != 0;
+    uint64_t magnitude = value;
+    if (negative) {
+        uint64_t widthMask = widthBits < 64 ? (uint64_t{1} << widthBits) - 1 : ~uint64_t{0};
+        magnitude = (~value + 1) & widthMask;
+    }
+
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    // Built least significant digit first, then reversed
+    std::string text;
+    std::string reversedSeparator(separator.rbegin(), separator.rend());
+    auto group = grouping.begin();
+    uint32_t groupSize = group != grouping.end() ? *group : 0;
+    uint32_t inGroup = 0;
+    for (size_t i = 0; i < count; i++) {
+        text.push_back(digits[i]);
+        if (groupSize == 0 || ++inGroup != groupSize || i + 1 == count) continue;
+
+        text += reversedSeparator;
+        inGroup = 0;
+        if (group != grouping.end()) {
+            for (groupSize = 0, ++group; group != grouping.end(); ++group) {
+                if (*group != 0) {
+                    groupSize = *group;
+                    break;
+                }
+                groupSize = *(group - 1);
+            }
+        }
+    }
+
+    if (negative) text.push_back('-');
+    std::reverse(text.begin(), text.end());
+    return text;
+}
+
+// Whether a snapshot field holds its whole value, given the full length its getter
+// reported; a field the getter could not fill is left empty
+static bool snapshot_field_complete(int length, char* field, size_t fieldSize) {
+    if (length < 0) field[0] = '\0';
+    return length >= 0 && static_cast<size_t>(length) < fieldSize;
+}
+
+int calculator_get_all_radix_results(CalculatorInstance* instance, CalcRadixSnapshot* snapshot) {
+    if (!instance || !instance->manager || !snapshot) return -1;
+
+    EngineLock lock;
+
+    uint64_t value = 0;
+    if (!read_programmer_value(instance, &value)) {
+        snapshot->value = 0;
+        bool complete = true;
+        complete &= snapshot_field_complete(calculator_get_result_hex(instance, snapshot->hex, sizeof(snapshot->hex)),
+                                            snapshot->hex, sizeof(snapshot->hex));
+        complete &= snapshot_field_complete(calculator_get_result_dec(instance, snapshot->dec, sizeof(snapshot->dec)),
+                                            snapshot->dec, sizeof(snapshot->dec));
+        complete &= snapshot_field_complete(calculator_get_result_oct(instance, snapshot->oct, sizeof(snapshot->oct)),
+                                            snapshot->oct, sizeof(snapshot->oct));
+        complete &= snapshot_field_complete(calculator_get_result_bin(instance, snapshot->bin, sizeof(snapshot->bin)),
+                                            snapshot->bin, sizeof(snapshot->bin));
+        complete &= snapshot_field_complete(calculator_get_binary_display(instance, snapshot->bits, sizeof(snapshot->bits)),
+                                            snapshot->bits, sizeof(snapshot->bits));
+        return complete ? 0 : -2;
+    }
+
+    int widthBits = word_width_bits(instance->manager->GetCurrentNumWidth());
+    const LocalePack& locale = instance->resourceProvider->Locale();
+    std::string separator = wstring_to_utf8(locale.thousand);
+    std::string dec = format_signed_decimal(value, widthBits, separator, parse_grouping(locale.grouping));
+
+    snapshot->value = value;
+    bool complete = true;
+    complete &= snapshot_field_complete(copy_to_buffer(format_grouped(value, 4, 4), snapshot->hex, sizeof(snapshot->hex)),
+                                        snapshot->hex, sizeof(snapshot->hex));
+    complete &= snapshot_field_complete(copy_to_buffer(dec, snapshot->dec, sizeof(snapshot->dec)),
+                                        snapshot->dec, sizeof(snapshot->dec));
+    complete &= snapshot_field_complete(copy_to_buffer(format_grouped(value, 3, 3), snapshot->oct, sizeof(snapshot->oct)),
+                                        snapshot->oct, sizeof(snapshot->oct));
+    complete &= snapshot_field_complete(copy_to_buffer(format_grouped(value, 1, 4), snapshot->bin, sizeof(snapshot->bin)),
+                                        snapshot->bin, sizeof(snapshot->bin));
+
+    for (int i = 0; i < 64; i++) {
+        snapshot->bits[i] = (value >> (63 - i)) & 1 ? '1' : '0';
+    }
+    snapshot->bits[64] = '\0';
+    return complete ? 1 : -2;
+}
+
+int calculator_get_value_bits(CalculatorInstance* instance, uint64_t* bits, int* word_width) {
+    if (!instance || !instance->manager) return 0;
+
+    EngineLock lock;
+
+    uint64_t value = 0;
+    if (!read_programmer_value(instance, &value)) return 0;
+
+    if (bits) *bits = value;
+    if (word_width) *word_width = word_width_bits(instance->manager->GetCurrentNumWidth());
+    return 1;
+}
+
+int calculator_toggle_bits(CalculatorInstance* instance, uint64_t mask) {
+    if (!instance || !instance->manager || !instance->display) return 0;
+
+    EngineLock lock;
+
+    uint64_t value = 0;
+    if (!read_programmer_value(instance, &value)) return 0;
+
+    int widthBits = word_width_bits(instance->manager->GetCurrentNumWidth());
+    const uint64_t signBit = uint64_t{1} << (widthBits - 1);
+    mask &= signBit | (signBit - 1);
+    if (mask == 0) return 1;
+    value ^= mask;
+
+    // Enter the new value once, like keypad input, instead of one CMD_BINPOS per toggled
+    // bit. Typed entry stops at the largest positive value, so the sign bit is set after.
+    const uint64_t magnitude = value & ~signBit;
+    std::string digits;
+    switch (instance->currentRadix) {
+        case CALC_RADIX_HEX:    digits = format_grouped(magnitude, 4, 64); break;
+        case CALC_RADIX_OCTAL:  digits = format_grouped(magnitude, 3, 64); break;
+        case CALC_RADIX_BINARY: digits = format_grouped(magnitude, 1, 64); break;
+        default:                digits = std::to_string(magnitude); break;
+    }
+
+    instance->display->BeginUpdate();
+    apply_command(instance, CMD_CENTR);
+    for (char c : digits) {
+        apply_command(instance, c <= '9' ? CMD_0 + (c - '0') : CMD_A + (c - 'A'));
+    }
+    if (value & signBit) apply_command(instance, CMD_BINPOS(widthBits - 1));
+    instance->display->EndUpdate();
+    return 1;
+}
+
+// ============================================================================
+// Word Size Functions (for Programmer Mode)
+// ============================================================================
+
+void calculator_set_word_width(CalculatorInstance* instance, CalcWordType word_type) {
+    if (!instance || !instance->manager) return;
+
+    EngineLock lock;
+
+    CalculationManager::Command cmd;
+    switch (word_type) {
+        case CALC_WORD_QWORD: cmd = CalculationManager::Command::CommandQword; break;
+        case CALC_WORD_DWORD: cmd = CalculationManager::Command::CommandDword; break;
+        case CALC_WORD_WORD:  cmd = CalculationManager::Command::CommandWord; break;
         case CALC_WORD_BYTE:  cmd = CalculationManager::Command::CommandByte; break;
         default:              cmd = CalculationManager::Command::CommandQword; break;
     }
@@ -619,6 +1532,7 @@ void calculator_set_word_width(CalculatorInstance* instance, CalcWordType word_t
 }
 
 int calculator_get_word_width(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         auto numwidth = instance->manager->GetCurrentNumWidth();
         switch (numwidth) {
@@ -656,6 +1570,8 @@ int calculator_get_carry_flag(CalculatorInstance* instance) {
 void calculator_set_angle_type(CalculatorInstance* instance, CalcAngleType angle_type) {
     if (!instance || !instance->manager) return;
 
+    EngineLock lock;
+
     CalculationManager::Command cmd;
     switch (angle_type) {
         case CALC_ANGLE_DEGREES:  cmd = CalculationManager::Command::CommandDEG; break;
@@ -669,6 +1585,7 @@ void calculator_set_angle_type(CalculatorInstance* instance, CalcAngleType angle
 }
 
 int calculator_get_angle_type(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         auto mode = instance->manager->GetCurrentDegreeMode();
         switch (mode) {
@@ -685,33 +1602,97 @@ int calculator_get_angle_type(CalculatorInstance* instance) {
 // Memory Functions Implementation
 // ============================================================================
 
+// How the current value was produced: a number in decimal (exact for typed input and in
+// programmer mode), or the finished equation that computed it so it can be evaluated again
+static MemoryTerm current_value_term(CalculatorInstance* instance, MemoryOperation operation) {
+    const CalcDisplayImpl* display = instance->display.get();
+    MemoryTerm term;
+    term.operation = operation;
+    term.mode = instance->currentMode;
+    if (instance->currentMode == CALC_MODE_PROGRAMMER) {
+        term.value = instance->manager->GetResultForRadix(10, 64, false);
+    } else if (!display->numberEntry && display->ExpressionComplete() && display->expressionCommands &&
+               !display->expressionCommands->empty()) {
+        term.expression = std::make_shared<ExpressionCommandList>(*display->expressionCommands);
+    } else {
+        term.value = display->primaryDisplay;
+    }
+    return term;
+}
+
+// Apply `term` to memory slot `index` and record it in memoryTerms the way the engine
+// applies it: nothing happens in an error state, M+ and M- on an empty memory store the
+// value (M- as x - 2x), and the oldest slots are dropped past the engine's limit
+static void apply_memory_term(CalculatorInstance* instance, const MemoryTerm& term, unsigned int index) {
+    CalcDisplayImpl* display = instance->display.get();
+    auto& slots = instance->memoryTerms;
+    bool tracked = !display->hasError && slots.size() == display->memorizedNumbers.size();
+    bool wasEmpty = display->memorizedNumbers.empty();
+
+    switch (term.operation) {
+        case MemoryOperation::Store:    instance->manager->MemorizeNumber(); break;
+        case MemoryOperation::Add:      instance->manager->MemorizedNumberAdd(index); break;
+        case MemoryOperation::Subtract: instance->manager->MemorizedNumberSubtract(index); break;
+    }
+    if (!tracked) return;
+
+    if (term.operation == MemoryOperation::Store || wasEmpty) {
+        MemoryTerm stored = term;
+        stored.operation = MemoryOperation::Store;
+        slots.insert(slots.begin(), std::vector<MemoryTerm>{stored});
+        if (term.operation == MemoryOperation::Subtract) {
+            slots.front().push_back(term);
+            slots.front().push_back(term);
+        }
+    } else if (index < slots.size() && !slots[index].empty()) {
+        if (slots[index].size() < MAX_MEMORY_TERMS) {
+            slots[index].push_back(term);
+        } else {
+            slots[index].clear();
+        }
+    }
+    if (slots.size() > display->memorizedNumbers.size()) {
+        slots.resize(display->memorizedNumbers.size());
+    }
+}
+
+static void apply_memory_operation(CalculatorInstance* instance, MemoryOperation operation, unsigned int index) {
+    apply_memory_term(instance, current_value_term(instance, operation), index);
+}
+
 void calculator_memory_store(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
-        instance->manager->MemorizeNumber();
+        apply_memory_operation(instance, MemoryOperation::Store, 0);
     }
 }
 
 void calculator_memory_recall(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->MemorizedNumberLoad(0);
     }
 }
 
 void calculator_memory_add(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
-        instance->manager->MemorizedNumberAdd(0);
+        apply_memory_operation(instance, MemoryOperation::Add, 0);
     }
 }
 
 void calculator_memory_subtract(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
-        instance->manager->MemorizedNumberSubtract(0);
+        apply_memory_operation(instance, MemoryOperation::Subtract, 0);
     }
 }
 
 void calculator_memory_clear(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->MemorizedNumberClearAll();
+        instance->memoryTerms.clear();
     }
 }
 
@@ -734,26 +1715,34 @@ int calculator_memory_get_at(CalculatorInstance* instance, int index, char* buff
 }
 
 void calculator_memory_load_at(CalculatorInstance* instance, int index) {
+    EngineLock lock;
     if (instance && instance->manager && index >= 0) {
         instance->manager->MemorizedNumberLoad(static_cast<unsigned int>(index));
     }
 }
 
 void calculator_memory_add_at(CalculatorInstance* instance, int index) {
+    EngineLock lock;
     if (instance && instance->manager && index >= 0) {
-        instance->manager->MemorizedNumberAdd(static_cast<unsigned int>(index));
+        apply_memory_operation(instance, MemoryOperation::Add, static_cast<unsigned int>(index));
     }
 }
 
 void calculator_memory_subtract_at(CalculatorInstance* instance, int index) {
+    EngineLock lock;
     if (instance && instance->manager && index >= 0) {
-        instance->manager->MemorizedNumberSubtract(static_cast<unsigned int>(index));
+        apply_memory_operation(instance, MemoryOperation::Subtract, static_cast<unsigned int>(index));
     }
 }
 
 void calculator_memory_clear_at(CalculatorInstance* instance, int index) {
+    EngineLock lock;
     if (instance && instance->manager && index >= 0) {
         unsigned int uIndex = static_cast<unsigned int>(index);
+        auto& slots = instance->memoryTerms;
+        if (slots.size() == instance->display->memorizedNumbers.size() && uIndex < slots.size()) {
+            slots.erase(slots.begin() + index);
+        }
 
         instance->manager->MemorizedNumberClear(uIndex);
 
@@ -768,8 +1757,10 @@ void calculator_memory_clear_at(CalculatorInstance* instance, int index) {
 }
 
 void calculator_memory_clear_all(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->MemorizedNumberClearAll();
+        instance->memoryTerms.clear();
     }
 }
 
@@ -778,6 +1769,7 @@ void calculator_memory_clear_all(CalculatorInstance* instance) {
 // ============================================================================
 
 int calculator_history_get_count(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         return static_cast<int>(instance->manager->GetHistoryItems().size());
     }
@@ -787,6 +1779,8 @@ int calculator_history_get_count(CalculatorInstance* instance) {
 int calculator_history_get_expression_at(CalculatorInstance* instance, int index, char* buffer, int buffer_size) {
     if (!instance || !instance->manager) return -1;
 
+    EngineLock lock;
+
     const auto& history = instance->manager->GetHistoryItems();
     if (index < 0 || index >= static_cast<int>(history.size())) {
         return -1;
@@ -799,6 +1793,8 @@ int calculator_history_get_expression_at(CalculatorInstance* instance, int index
 int calculator_history_get_result_at(CalculatorInstance* instance, int index, char* buffer, int buffer_size) {
     if (!instance || !instance->manager) return -1;
 
+    EngineLock lock;
+
     const auto& history = instance->manager->GetHistoryItems();
     if (index < 0 || index >= static_cast<int>(history.size())) {
         return -1;
@@ -821,22 +1817,9 @@ void calculator_set_history_load_mode(CalculatorInstance* instance, int enabled)
     }
 }
 
-void calculator_history_load_at(CalculatorInstance* instance, int index) {
-    if (!instance || !instance->manager) return;
-
-    const auto& history = instance->manager->GetHistoryItems();
-    if (index < 0 || index >= static_cast<int>(history.size())) return;
-
-    auto& historyItem = history[index];
-    auto& commands = historyItem->historyItemVector.spCommands;
-
-    if (!commands || commands->empty()) return;
-
-    // Reset calculator to clear current state (but keep memory)
-    instance->manager->Reset(false);
-
-    // Resend all commands from the history item
-    for (auto& command : *commands) {
+// Resend the keystrokes that produced an expression command list
+static void replay_expression_commands(CalculatorInstance* instance, const ExpressionCommandList& commands) {
+    for (auto& command : commands) {
         auto commandType = command->GetCommandType();
 
         switch (commandType) {
@@ -874,6 +1857,26 @@ void calculator_history_load_at(CalculatorInstance* instance, int index) {
                 break;
         }
     }
+}
+
+void calculator_history_load_at(CalculatorInstance* instance, int index) {
+    if (!instance || !instance->manager) return;
+
+    EngineLock lock;
+
+    const auto& history = instance->manager->GetHistoryItems();
+    if (index < 0 || index >= static_cast<int>(history.size())) return;
+
+    auto& historyItem = history[index];
+    auto& commands = historyItem->historyItemVector.spCommands;
+
+    if (!commands || commands->empty()) return;
+
+    // Reset calculator to clear current state (but keep memory)
+    instance->manager->Reset(false);
+
+    // Resend all commands from the history item
+    replay_expression_commands(instance, *commands);
 
     // Send equals to update display and create history entry
     instance->manager->SendCommand(static_cast<CalculationManager::Command>(IDC_EQU));
@@ -893,6 +1896,7 @@ void calculator_history_load_at(CalculatorInstance* instance, int index) {
 }
 
 int calculator_history_remove_at(CalculatorInstance* instance, int index) {
+    EngineLock lock;
     if (instance && instance->manager && index >= 0) {
         return instance->manager->RemoveHistoryItem(static_cast<unsigned int>(index)) ? 1 : 0;
     }
@@ -900,16 +1904,758 @@ int calculator_history_remove_at(CalculatorInstance* instance, int index) {
 }
 
 void calculator_history_clear(CalculatorInstance* instance) {
+    EngineLock lock;
     if (instance && instance->manager) {
         instance->manager->ClearHistory();
     }
 }
 
+// ============================================================================
+// History Serialization
+// ============================================================================
+
+using HistoryItems = std::vector<std::shared_ptr<CalculationManager::HISTORYITEM>>;
+
+// History storage used by each mode; programmer mode shares the standard history
+static CalculationManager::CalculatorMode history_mode_for(CalcMode mode) {
+    return mode == CALC_MODE_SCIENTIFIC ? CalculationManager::CalculatorMode::Scientific
+                                        : CalculationManager::CalculatorMode::Standard;
+}
+
+// Append-only little-endian encoder for the binary formats below
+class BinaryWriter {
+public:
+    std::string bytes;
+
+    template <typename T>
+    void Write(T value) {
+        static_assert(std::is_integral_v<T>, "integers only");
+        for (size_t i = 0; i < sizeof(T); i++) {
+            bytes.push_back(static_cast<char>(static_cast<uint64_t>(value) >> (8 * i)));
+        }
+    }
+
+    // Length-prefixed UTF-8
+    void WriteString(std::wstring_view text) {
+        size_t lengthAt = bytes.size();
+        Write<uint32_t>(0);
+        append_utf8(bytes, text);
+        uint32_t length = static_cast<uint32_t>(bytes.size() - lengthAt - sizeof(uint32_t));
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            bytes[lengthAt + i] = static_cast<char>(length >> (8 * i));
+        }
+    }
+
+    void WriteInts(const std::vector<int>* values) {
+        Write<uint32_t>(values ? static_cast<uint32_t>(values->size()) : 0);
+        if (!values) return;
+        for (int value : *values) Write<int32_t>(value);
+    }
+};
+
+// Bounds-checked decoder; any overrun latches `ok` to false and yields zeros
+class BinaryReader {
+public:
+    BinaryReader(const void* data, size_t size)
+        : m_pos(static_cast<const unsigned char*>(data)), m_end(m_pos + size) {}
+
+    bool ok = true;
+
+    bool AtEnd() const { return m_pos == m_end; }
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_integral_v<T>, "integers only");
+        if (!Require(sizeof(T))) return T{};
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value |= static_cast<uint64_t>(m_pos[i]) << (8 * i);
+        }
+        m_pos += sizeof(T);
+        return static_cast<T>(value);
+    }
+
+    std::wstring ReadString() {
+        uint32_t length = Read<uint32_t>();
+        if (!Require(length)) return {};
+        std::wstring text = utf8_to_wstring(std::string_view(reinterpret_cast<const char*>(m_pos), length));
+        m_pos += length;
+        return text;
+    }
+
+    std::shared_ptr<std::vector<int>> ReadInts() {
+        uint32_t count = Read<uint32_t>();
+        if (!Require(static_cast<size_t>(count) * sizeof(int32_t))) return nullptr;
+        auto values = std::make_shared<std::vector<int>>();
+        values->reserve(count);
+        for (uint32_t i = 0; i < count; i++) values->push_back(Read<int32_t>());
+        return values;
+    }
+
+    // Guard element counts before reserving so corrupt data cannot request huge allocations
+    bool Require(size_t bytes) {
+        if (ok && static_cast<size_t>(m_end - m_pos) >= bytes) return true;
+        ok = false;
+        return false;
+    }
+
+private:
+    const unsigned char* m_pos;
+    const unsigned char* m_end;
+};
+
+// Format: "WCHS" magic, uint16 version, uint16 reserved, uint32 item count, then per item
+// the expression and result strings, the tokens (text, command index) and the expression
+// commands (type byte followed by that command's fields). Integers are little-endian and
+// strings are uint32 length-prefixed UTF-8.
+static constexpr uint32_t HISTORY_MAGIC = 0x53484357;  // "WCHS"
+static constexpr uint16_t HISTORY_VERSION = 1;
+
+static void write_history_commands(BinaryWriter& writer, const ExpressionCommandList* commands) {
+    writer.Write<uint32_t>(commands ? static_cast<uint32_t>(commands->size()) : 0);
+    if (!commands) return;
+
+    for (const auto& command : *commands) {
+        auto type = command->GetCommandType();
+        writer.Write<uint8_t>(static_cast<uint8_t>(type));
+        switch (type) {
+            case CalculationManager::CommandType::UnaryCommand:
+                writer.WriteInts(static_cast<const IUnaryCommand*>(command.get())->GetCommands().get());
+                break;
+            case CalculationManager::CommandType::BinaryCommand:
+                writer.Write<int32_t>(static_cast<const IBinaryCommand*>(command.get())->GetCommand());
+                break;
+            case CalculationManager::CommandType::OperandCommand: {
+                auto operand = static_cast<const IOpndCommand*>(command.get());
+                uint8_t flags = (operand->IsNegative() ? 1 : 0) | (operand->IsDecimalPresent() ? 2 : 0) |
+                                (operand->IsSciFmt() ? 4 : 0);
+                writer.Write<uint8_t>(flags);
+                writer.WriteInts(operand->GetCommands().get());
+                break;
+            }
+            case CalculationManager::CommandType::Parentheses:
+                writer.Write<int32_t>(static_cast<const IParenthesisCommand*>(command.get())->GetCommand());
+                break;
+        }
+    }
+}
+
+static std::shared_ptr<ExpressionCommandList> read_history_commands(BinaryReader& reader) {
+    uint32_t count = reader.Read<uint32_t>();
+    if (!reader.Require(count)) return nullptr;
+
+    auto commands = std::make_shared<ExpressionCommandList>();
+    commands->reserve(count);
+    for (uint32_t i = 0; i < count && reader.ok; i++) {
+        switch (static_cast<CalculationManager::CommandType>(reader.Read<uint8_t>())) {
+            case CalculationManager::CommandType::UnaryCommand: {
+                auto list = reader.ReadInts();
+                if (!list || list->empty() || list->size() > 2) return nullptr;
+                commands->push_back(list->size() == 1 ? std::make_shared<CUnaryCommand>((*list)[0])
+                                                      : std::make_shared<CUnaryCommand>((*list)[0], (*list)[1]));
+                break;
+            }
+            case CalculationManager::CommandType::BinaryCommand:
+                commands->push_back(std::make_shared<CBinaryCommand>(reader.Read<int32_t>()));
+                break;
+            case CalculationManager::CommandType::OperandCommand: {
+                uint8_t flags = reader.Read<uint8_t>();
+                auto list = reader.ReadInts();
+                if (!list) return nullptr;
+                commands->push_back(std::make_shared<COpndCommand>(list, (flags & 1) != 0, (flags & 2) != 0, (flags & 4) != 0));
+                break;
+            }
+            case CalculationManager::CommandType::Parentheses:
+                commands->push_back(std::make_shared<CParentheses>(reader.Read<int32_t>()));
+                break;
+            default:
+                return nullptr;
+        }
+    }
+    return reader.ok ? commands : nullptr;
+}
+
+static void write_history(BinaryWriter& writer, const HistoryItems& items) {
+    writer.Write<uint32_t>(HISTORY_MAGIC);
+    writer.Write<uint16_t>(HISTORY_VERSION);
+    writer.Write<uint16_t>(0);
+    writer.Write<uint32_t>(static_cast<uint32_t>(items.size()));
+
+    for (const auto& item : items) {
+        const auto& vector = item->historyItemVector;
+        writer.WriteString(vector.expression);
+        writer.WriteString(vector.result);
+
+        const auto* tokens = vector.spTokens.get();
+        writer.Write<uint32_t>(tokens ? static_cast<uint32_t>(tokens->size()) : 0);
+        if (tokens) {
+            for (const auto& token : *tokens) {
+                writer.WriteString(token.first);
+                writer.Write<int32_t>(token.second);
+            }
+        }
+
+        write_history_commands(writer, vector.spCommands.get());
+    }
+}
+
+static bool read_history(BinaryReader& reader, HistoryItems& items) {
+    if (reader.Read<uint32_t>() != HISTORY_MAGIC || reader.Read<uint16_t>() != HISTORY_VERSION) return false;
+    reader.Read<uint16_t>();
+
+    uint32_t count = reader.Read<uint32_t>();
+    if (!reader.Require(count)) return false;
+
+    items.clear();
+    items.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        auto item = std::make_shared<CalculationManager::HISTORYITEM>();
+        auto& vector = item->historyItemVector;
+        vector.expression = reader.ReadString();
+        vector.result = reader.ReadString();
+
+        uint32_t tokenCount = reader.Read<uint32_t>();
+        if (!reader.Require(tokenCount)) return false;
+        vector.spTokens = std::make_shared<std::vector<std::pair<std::wstring, int>>>();
+        vector.spTokens->reserve(tokenCount);
+        for (uint32_t t = 0; t < tokenCount && reader.ok; t++) {
+            std::wstring text = reader.ReadString();
+            vector.spTokens->emplace_back(std::move(text), reader.Read<int32_t>());
+        }
+
+        vector.spCommands = read_history_commands(reader);
+        if (!reader.ok || !vector.spCommands) return false;
+        items.push_back(std::move(item));
+    }
+    return reader.ok;
+}
+
+// Minimal reader for the compatibility format of calculator_history_set_from_vector:
+// [{"expression": "...", "result": "..."}, ...]. Other members are skipped if they hold
+// strings, numbers, true, false or null.
+class HistoryJsonReader {
+public:
+    explicit HistoryJsonReader(const char* text) : m_pos(text) {}
+
+    bool Parse(HistoryItems& items) {
+        if (!Consume('[')) return false;
+        if (Consume(']')) return AtEnd();
+
+        do {
+            auto item = std::make_shared<CalculationManager::HISTORYITEM>();
+            if (!ParseItem(item->historyItemVector)) return false;
+            items.push_back(std::move(item));
+        } while (Consume(','));
+
+        return Consume(']') && AtEnd();
+    }
+
+private:
+    const char* m_pos;
+
+    void SkipSpaces() {
+        while (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r') m_pos++;
+    }
+
+    bool Consume(char c) {
+        SkipSpaces();
+        if (*m_pos != c) return false;
+        m_pos++;
+        return true;
+    }
+
+    bool AtEnd() {
+        SkipSpaces();
+        return *m_pos == '\0';
+    }
+
+    bool ParseItem(CalculationManager::HISTORYITEMVECTOR& vector) {
+        if (!Consume('{')) return false;
+        if (!Consume('}')) {
+            do {
+                std::string key;
+                if (!ParseString(key) || !Consume(':')) return false;
+                SkipSpaces();
+                if (*m_pos == '"') {
+                    std::string value;
+                    if (!ParseString(value)) return false;
+                    if (key == "expression") vector.expression = utf8_to_wstring(value);
+                    if (key == "result") vector.result = utf8_to_wstring(value);
+                } else if (!SkipScalar()) {
+                    return false;
+                }
+            } while (Consume(','));
+            if (!Consume('}')) return false;
+        }
+
+        // No command list is available, so tokens are the space-separated expression parts
+        vector.spTokens = std::make_shared<std::vector<std::pair<std::wstring, int>>>();
+        vector.spCommands = std::make_shared<ExpressionCommandList>();
+        std::wstring_view expression = vector.expression;
+        while (!expression.empty()) {
+            size_t space = expression.find(L' ');
+            if (space != 0) vector.spTokens->emplace_back(std::wstring(expression.substr(0, space)), -1);
+            if (space == std::wstring_view::npos) break;
+            expression.remove_prefix(space + 1);
+        }
+        return true;
+    }
+
+    bool ParseString(std::string& out) {
+        if (!Consume('"')) return false;
+        while (*m_pos != '"') {
+            unsigned char c = static_cast<unsigned char>(*m_pos++);
+            if (c == '\0' || c < 0x20) return false;
+            if (c != '\\') {
+                out.push_back(static_cast<char>(c));
+                continue;
+            }
+
+            switch (*m_pos++) {
+                case '"':  out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/':  out.push_back('/'); break;
+                case 'b':  out.push_back('\b'); break;
+                case 'f':  out.push_back('\f'); break;
+                case 'n':  out.push_back('\n'); break;
+                case 'r':  out.push_back('\r'); break;
+                case 't':  out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t code_point = 0;
+                    if (!ParseHex4(code_point)) return false;
+                    if (code_point >= 0xD800 && code_point <= 0xDBFF && m_pos[0] == '\\' && m_pos[1] == 'u') {
+                        const char* resume = m_pos;
+                        m_pos += 2;
+                        uint32_t low = 0;
+                        if (ParseHex4(low) && low >= 0xDC00 && low <= 0xDFFF) {
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            m_pos = resume;
+                        }
+                    }
+                    wchar_t units[2];
+                    size_t count = 0;
+                    if (sizeof(wchar_t) == 2 && code_point > 0xFFFF) {
+                        units[count++] = static_cast<wchar_t>(0xD800 + ((code_point - 0x10000) >> 10));
+                        units[count++] = static_cast<wchar_t>(0xDC00 + ((code_point - 0x10000) & 0x3FF));
+                    } else {
+                        units[count++] = static_cast<wchar_t>(code_point);
+                    }
+                    append_utf8(out, std::wstring_view(units, count));
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        m_pos++;
+        return true;
+    }
+
+    bool ParseHex4(uint32_t& value) {
+        for (int i = 0; i < 4; i++) {
+            char c = *m_pos++;
+            uint32_t digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else return false;
+            value = (value << 4) | digit;
+        }
+        return true;
+    }
+
+    bool SkipScalar() {
+        const char* start = m_pos;
+        while (*m_pos && std::strchr(",}] \t\r\n", *m_pos) == nullptr) m_pos++;
+        return m_pos != start;
+    }
+};
+
+static bool parse_history_json(const char* json, HistoryItems& items) {
+    return HistoryJsonReader(json).Parse(items);
+}
+
+int calculator_history_save(CalculatorInstance* instance, CalcMode mode, void* buffer, int buffer_size) {
+    if (!instance || !instance->manager) return -1;
+
+    EngineLock lock;
+
+    BinaryWriter writer;
+    write_history(writer, instance->manager->GetHistoryItems(history_mode_for(mode)));
+
+    // Binary data is not truncated: a buffer that is too small is left untouched
+    int size = static_cast<int>(writer.bytes.size());
+    if (buffer && buffer_size >= size) {
+        std::memcpy(buffer, writer.bytes.data(), writer.bytes.size());
+    }
+    return size;
+}
+
+int calculator_history_restore(CalculatorInstance* instance, CalcMode mode, const void* data, int size) {
+    if (!instance || !instance->manager || !data || size < 0) return -1;
+
+    EngineLock lock;
+
+    HistoryItems items;
+    BinaryReader reader(data, static_cast<size_t>(size));
+    if (!read_history(reader, items) || !reader.AtEnd()) return -2;
+
+    instance->manager->SetHistory(history_mode_for(mode), items);
+    return static_cast<int>(items.size());
+}
+
+// ============================================================================
+// Instance Snapshot
+// ============================================================================
+
+// Format: "WCSN" magic, uint16 version, uint16 reserved, the settings (mode, radix, word
+// width, angle type), a flags byte (carry flag, history load mode, error, number entry,
+// finished equation), the memory slots (display string, then the slot's terms: operation,
+// mode and either expression commands or a decimal number), the primary display, the
+// engine's expression commands, then the standard and scientific history in the
+// calculator_history_save format.
+static constexpr uint32_t SNAPSHOT_MAGIC = 0x4E534357;  // "WCSN"
+static constexpr uint16_t SNAPSHOT_VERSION = 3;
+
+struct InstanceSnapshot {
+    CalcMode mode = CALC_MODE_STANDARD;
+    CalcRadixType radix = CALC_RADIX_DECIMAL;
+    CalcWordType wordType = CALC_WORD_QWORD;
+    CalcAngleType angleType = CALC_ANGLE_DEGREES;
+    bool carryFlag = false;
+    bool historyLoadMode = false;
+    bool hasError = false;
+    bool numberEntry = false;  // The display is a number being typed
+    bool complete = false;     // `expression` is a finished equation whose result is shown
+    std::vector<std::wstring> memory;
+    std::vector<std::vector<MemoryTerm>> memoryTerms;  // Parallel to `memory`, empty if not tracked
+    std::wstring display;
+    std::shared_ptr<ExpressionCommandList> expression;
+    HistoryItems standardHistory;
+    HistoryItems scientificHistory;
+};
+
+static bool read_snapshot(BinaryReader& reader, InstanceSnapshot& snapshot) {
+    if (reader.Read<uint32_t>() != SNAPSHOT_MAGIC || reader.Read<uint16_t>() != SNAPSHOT_VERSION) return false;
+    reader.Read<uint16_t>();
+
+    uint8_t mode = reader.Read<uint8_t>();
+    uint8_t radix = reader.Read<uint8_t>();
+    uint8_t wordType = reader.Read<uint8_t>();
+    uint8_t angleType = reader.Read<uint8_t>();
+    if (mode > CALC_MODE_PROGRAMMER || wordType > CALC_WORD_BYTE || angleType > CALC_ANGLE_GRADIANS) return false;
+    if (radix != CALC_RADIX_DECIMAL && radix != CALC_RADIX_HEX && radix != CALC_RADIX_OCTAL && radix != CALC_RADIX_BINARY) {
+        return false;
+    }
+    snapshot.mode = static_cast<CalcMode>(mode);
+    snapshot.radix = static_cast<CalcRadixType>(radix);
+    snapshot.wordType = static_cast<CalcWordType>(wordType);
+    snapshot.angleType = static_cast<CalcAngleType>(angleType);
+
+    uint8_t flags = reader.Read<uint8_t>();
+    snapshot.carryFlag = (flags & 1) != 0;
+    snapshot.historyLoadMode = (flags & 2) != 0;
+    snapshot.hasError = (flags & 4) != 0;
+    snapshot.numberEntry = (flags & 8) != 0;
+    snapshot.complete = (flags & 16) != 0;
+
+    uint32_t memoryCount = reader.Read<uint32_t>();
+    if (!reader.Require(memoryCount)) return false;
+    snapshot.memory.reserve(memoryCount);
+    snapshot.memoryTerms.resize(memoryCount);
+    for (uint32_t i = 0; i < memoryCount && reader.ok; i++) {
+        snapshot.memory.push_back(reader.ReadString());
+
+        uint32_t termCount = reader.Read<uint32_t>();
+        if (termCount > MAX_MEMORY_TERMS || !reader.Require(termCount)) return false;
+        for (uint32_t j = 0; j < termCount && reader.ok; j++) {
+            MemoryTerm term;
+            uint8_t operation = reader.Read<uint8_t>();
+            uint8_t termMode = reader.Read<uint8_t>();
+            bool hasExpression = reader.Read<uint8_t>() != 0;
+            if (operation > static_cast<uint8_t>(MemoryOperation::Subtract) || termMode > CALC_MODE_PROGRAMMER) return false;
+            if ((j == 0) != (operation == static_cast<uint8_t>(MemoryOperation::Store))) return false;
+            term.operation = static_cast<MemoryOperation>(operation);
+            term.mode = static_cast<CalcMode>(termMode);
+            if (hasExpression) {
+                if (term.mode == CALC_MODE_PROGRAMMER) return false;
+                term.expression = read_history_commands(reader);
+                if (!term.expression) return false;
+            } else {
+                term.value = reader.ReadString();
+            }
+            snapshot.memoryTerms[i].push_back(std::move(term));
+        }
+    }
+    snapshot.display = reader.ReadString();
+
+    snapshot.expression = read_history_commands(reader);
+    return snapshot.expression && read_history(reader, snapshot.standardHistory) &&
+           read_history(reader, snapshot.scientificHistory) && reader.ok;
+}
+
+// Type a display string back into the engine: digits (A-F in programmer mode), the
+// decimal separator, the exponent and signs. Grouping separators are skipped.
+static void enter_display_value(CalculatorInstance* instance, std::wstring_view text) {
+    const std::wstring& decimal = instance->resourceProvider->Locale().decimal;
+    auto send = [instance](int command) {
+        instance->manager->SendCommand(static_cast<CalculationManager::Command>(command));
+    };
+
+    bool negative = false;
+    bool inExponent = false;
+    for (size_t i = 0; i < text.size(); i++) {
+        wchar_t c = text[i];
+        if (c >= L'0' && c <= L'9') {
+            send(CMD_0 + (c - L'0'));
+        } else if (c >= L'A' && c <= L'F') {
+            send(CMD_A + (c - L'A'));
+        } else if (!decimal.empty() && text.compare(i, decimal.size(), decimal) == 0) {
+            send(CMD_DECIMAL);
+            i += decimal.size() - 1;
+        } else if (c == L'e' && !inExponent) {
+            // The mantissa sign must be applied before the exponent starts
+            if (negative) send(CMD_NEGATE);
+            negative = false;
+            inExponent = true;
+            send(CMD_EXP);
+        } else if (c == L'-') {
+            if (inExponent) send(CMD_NEGATE);
+            else negative = true;
+        }
+    }
+    if (negative) send(CMD_NEGATE);
+}
+
+// The snapshot shares the source's history items and expression command list. History
+// items never change once added, but the engine keeps appending to the command list of
+// an expression in progress, so callers hold the engine lock until the snapshot has been
+// written or applied.
+static InstanceSnapshot capture_snapshot(CalculatorInstance* instance) {
+    const CalcDisplayImpl* display = instance->display.get();
+    InstanceSnapshot snapshot;
+    snapshot.mode = instance->currentMode;
+    snapshot.radix = instance->currentRadix;
+    snapshot.wordType = instance->currentWordType;
+    snapshot.angleType = instance->currentAngleType;
+    snapshot.carryFlag = instance->carryFlag != 0;
+    snapshot.historyLoadMode = instance->isInHistoryLoadMode;
+    snapshot.hasError = display->hasError;
+    snapshot.numberEntry = display->numberEntry;
+    snapshot.memory = display->memorizedNumbers;
+    if (instance->memoryTerms.size() == snapshot.memory.size()) {
+        snapshot.memoryTerms = instance->memoryTerms;
+    } else {
+        snapshot.memoryTerms.resize(snapshot.memory.size());
+    }
+    snapshot.display = display->primaryDisplay;
+    snapshot.expression = display->expressionCommands ? display->expressionCommands
+                                                      : std::make_shared<ExpressionCommandList>();
+    snapshot.complete = display->ExpressionComplete() && !snapshot.expression->empty();
+    snapshot.standardHistory = instance->manager->GetHistoryItems(CalculationManager::CalculatorMode::Standard);
+    snapshot.scientificHistory = instance->manager->GetHistoryItems(CalculationManager::CalculatorMode::Scientific);
+    return snapshot;
+}
+
+static void write_snapshot(BinaryWriter& writer, const InstanceSnapshot& snapshot) {
+    writer.Write<uint32_t>(SNAPSHOT_MAGIC);
+    writer.Write<uint16_t>(SNAPSHOT_VERSION);
+    writer.Write<uint16_t>(0);
+
+    writer.Write<uint8_t>(static_cast<uint8_t>(snapshot.mode));
+    writer.Write<uint8_t>(static_cast<uint8_t>(snapshot.radix));
+    writer.Write<uint8_t>(static_cast<uint8_t>(snapshot.wordType));
+    writer.Write<uint8_t>(static_cast<uint8_t>(snapshot.angleType));
+    writer.Write<uint8_t>(static_cast<uint8_t>((snapshot.carryFlag ? 1 : 0) | (snapshot.historyLoadMode ? 2 : 0) |
+                                               (snapshot.hasError ? 4 : 0) | (snapshot.numberEntry ? 8 : 0) |
+                                               (snapshot.complete ? 16 : 0)));
+
+    writer.Write<uint32_t>(static_cast<uint32_t>(snapshot.memory.size()));
+    for (size_t i = 0; i < snapshot.memory.size(); i++) {
+        writer.WriteString(snapshot.memory[i]);
+
+        writer.Write<uint32_t>(static_cast<uint32_t>(snapshot.memoryTerms[i].size()));
+        for (const auto& term : snapshot.memoryTerms[i]) {
+            writer.Write<uint8_t>(static_cast<uint8_t>(term.operation));
+            writer.Write<uint8_t>(static_cast<uint8_t>(term.mode));
+            writer.Write<uint8_t>(term.expression ? 1 : 0);
+            if (term.expression) {
+                write_history_commands(writer, term.expression.get());
+            } else {
+                writer.WriteString(term.value);
+            }
+        }
+    }
+    writer.WriteString(snapshot.display);
+
+    write_history_commands(writer, snapshot.expression.get());
+    write_history(writer, snapshot.standardHistory);
+    write_history(writer, snapshot.scientificHistory);
+}
+
+// Rebuild a memory term: a number is typed in scientific mode, which takes the most
+// digits, and an equation is evaluated again by the engine that first computed it
+static void restore_memory_term(CalculatorInstance* instance, const MemoryTerm& term) {
+    CalcMode mode = term.expression ? term.mode : CALC_MODE_SCIENTIFIC;
+    if (instance->currentMode != mode) {
+        if (mode == CALC_MODE_STANDARD) calculator_set_standard_mode(instance);
+        else calculator_set_scientific_mode(instance);
+    }
+
+    instance->manager->SendCommand(static_cast<CalculationManager::Command>(CMD_CLEAR));
+    if (term.expression) {
+        replay_expression_commands(instance, *term.expression);
+        instance->manager->SendCommand(static_cast<CalculationManager::Command>(IDC_EQU));
+    } else {
+        enter_display_value(instance, term.value);
+    }
+    apply_memory_term(instance, term, 0);
+}
+
+// Put the engine back into the error that shows `message`. The engine only enters an
+// error by evaluating something, so known failing inputs are tried until one produces
+// the same (localized) message; an unknown message falls back to division by zero.
+static void restore_error(CalculatorInstance* instance, const std::wstring& message) {
+    static const std::vector<std::vector<CalculatorCommand>> failingInputs = {
+        {CMD_1, CMD_DIVIDE, CMD_0, CMD_EQUALS},           // Cannot divide by zero
+        {CMD_0, CMD_DIVIDE, CMD_0, CMD_EQUALS},           // Result is undefined
+        {CMD_1, CMD_NEGATE, CMD_SQRT},                    // Invalid input
+        {CMD_5, CMD_0, CMD_0, CMD_0, CMD_FACTORIAL},      // Overflow
+    };
+
+    const CalcDisplayImpl* display = instance->display.get();
+    for (size_t attempt = 0; attempt <= failingInputs.size(); attempt++) {
+        const auto& commands = failingInputs[attempt % failingInputs.size()];
+        instance->manager->SendCommand(static_cast<CalculationManager::Command>(CMD_CLEAR));
+        for (CalculatorCommand command : commands) {
+            instance->manager->SendCommand(static_cast<CalculationManager::Command>(command));
+        }
+        if (display->hasError && display->primaryDisplay == message) return;
+    }
+}
+
+static void apply_snapshot(CalculatorInstance* instance, const InstanceSnapshot& snapshot) {
+    CalcDisplayImpl* display = instance->display.get();
+    display->BeginUpdate();
+    instance->suppressCallbacks = true;
+
+    // Mode switches clear the engine, so settings go first: word width lives in the
+    // programmer engine, the angle type in the scientific one, the radix only lasts
+    // while programmer mode is active
+    instance->manager->Reset(true);
+    instance->memoryTerms.clear();
+    calculator_set_programmer_mode(instance);
+    calculator_set_word_width(instance, snapshot.wordType);
+    calculator_set_scientific_mode(instance);
+    calculator_set_angle_type(instance, snapshot.angleType);
+
+    // Memory slots are listed newest first; storing oldest first rebuilds the same order.
+    // When every slot is tracked they are rebuilt from their terms at full precision,
+    // otherwise all of them are typed back from their display strings in the target mode.
+    bool memoryTracked = std::none_of(snapshot.memoryTerms.begin(), snapshot.memoryTerms.end(),
+                                      [](const auto& terms) { return terms.empty(); });
+    if (memoryTracked) {
+        for (auto it = snapshot.memoryTerms.rbegin(); it != snapshot.memoryTerms.rend(); ++it) {
+            for (const auto& term : *it) {
+                restore_memory_term(instance, term);
+            }
+        }
+        instance->manager->SendCommand(static_cast<CalculationManager::Command>(CMD_CLEAR));
+    }
+
+    switch (snapshot.mode) {
+        case CALC_MODE_STANDARD:
+            calculator_set_standard_mode(instance);
+            break;
+        case CALC_MODE_SCIENTIFIC:
+            if (instance->currentMode != CALC_MODE_SCIENTIFIC) calculator_set_scientific_mode(instance);
+            break;
+        case CALC_MODE_PROGRAMMER:
+            calculator_set_programmer_mode(instance);
+            break;
+    }
+    if (snapshot.mode == CALC_MODE_PROGRAMMER) {
+        calculator_set_radix(instance, snapshot.radix);
+    } else {
+        instance->currentRadix = snapshot.radix;
+    }
+
+    if (!memoryTracked) {
+        for (auto it = snapshot.memory.rbegin(); it != snapshot.memory.rend(); ++it) {
+            enter_display_value(instance, *it);
+            instance->manager->MemorizeNumber();
+            instance->manager->SendCommand(static_cast<CalculationManager::Command>(CMD_CLEAR));
+        }
+    }
+
+    // Rebuild the expression. A finished equation is evaluated again, which restores its
+    // result at full precision (and what a repeated '=' applies); its history entry is
+    // replaced with the stored history below.
+    replay_expression_commands(instance, *snapshot.expression);
+    display->numberEntry = false;
+    if (snapshot.hasError) {
+        restore_error(instance, snapshot.display);
+    } else {
+        if (snapshot.complete) {
+            instance->manager->SendCommand(static_cast<CalculationManager::Command>(IDC_EQU));
+        } else if (snapshot.numberEntry) {
+            // The number being typed continues with the next digit
+            enter_display_value(instance, snapshot.display);
+            display->numberEntry = true;
+        } else if (snapshot.expression->empty() && snapshot.display != L"0") {
+            // A value shown on its own (e.g. recalled from memory) comes back at display
+            // precision, as a result that the next digit replaces
+            enter_display_value(instance, snapshot.display);
+            instance->manager->SendCommand(static_cast<CalculationManager::Command>(IDC_EQU));
+        }
+    }
+
+    instance->manager->SetHistory(CalculationManager::CalculatorMode::Standard, snapshot.standardHistory);
+    instance->manager->SetHistory(CalculationManager::CalculatorMode::Scientific, snapshot.scientificHistory);
+
+    instance->carryFlag = snapshot.carryFlag ? 1 : 0;
+    instance->isInHistoryLoadMode = snapshot.historyLoadMode;
+
+    instance->suppressCallbacks = false;
+    display->EndUpdate();
+}
+
+int calculator_snapshot(CalculatorInstance* instance, void* buf, size_t* len) {
+    if (!instance || !instance->manager || !instance->display || !len) return -1;
+
+    EngineLock lock;
+
+    BinaryWriter writer;
+    write_snapshot(writer, capture_snapshot(instance));
+
+    size_t capacity = *len;
+    *len = writer.bytes.size();
+    if (!buf || capacity < writer.bytes.size()) return 1;
+
+    std::memcpy(buf, writer.bytes.data(), writer.bytes.size());
+    return 0;
+}
+
+int calculator_restore(CalculatorInstance* instance, const void* buf, size_t len) {
+    if (!instance || !instance->manager || !instance->display || !buf) return -1;
+
+    // Decode everything first so malformed data leaves the instance untouched
+    InstanceSnapshot snapshot;
+    BinaryReader reader(buf, len);
+    if (!read_snapshot(reader, snapshot) || !reader.AtEnd()) return -2;
+
+    EngineLock lock;
+    apply_snapshot(instance, snapshot);
+    return 0;
+}
+
 // ============================================================================
 // Per-Mode History Functions (NEW)
 // ============================================================================
 
 int calculator_history_get_count_for_mode(CalculatorInstance* instance, CalcMode mode) {
+    EngineLock lock;
     if (instance && instance->manager) {
         CalculationManager::CalculatorMode calcMode;
         switch (mode) {
@@ -934,6 +2680,8 @@ int calculator_history_get_count_for_mode(CalculatorInstance* instance, CalcMode
 int calculator_history_get_expression_at_for_mode(CalculatorInstance* instance, CalcMode mode, int index, char* buffer, int buffer_size) {
     if (!instance || !instance->manager) return -1;
 
+    EngineLock lock;
+
     CalculationManager::CalculatorMode calcMode;
     switch (mode) {
         case CALC_MODE_STANDARD:
@@ -962,6 +2710,8 @@ int calculator_history_get_expression_at_for_mode(CalculatorInstance* instance,
 int calculator_history_get_result_at_for_mode(CalculatorInstance* instance, CalcMode mode, int index, char* buffer, int buffer_size) {
     if (!instance || !instance->manager) return -1;
 
+    EngineLock lock;
+
     CalculationManager::CalculatorMode calcMode;
     switch (mode) {
         case CALC_MODE_STANDARD:
@@ -988,20 +2738,21 @@ int calculator_history_get_result_at_for_mode(CalculatorInstance* instance, Calc
 }
 
 void calculator_history_set_from_vector(CalculatorInstance* instance, const char* json_data) {
-    // This function would restore history from serialized data
-    // For now, we'll implement a simpler approach using the existing SetHistoryItems
-    // Note: A full implementation would require JSON parsing and reconstruction of HISTORYITEM objects
-    // This is a placeholder for future implementation
     if (!instance || !instance->manager || !json_data) return;
 
-    // TODO: Implement JSON deserialization and history restoration
-    // For now, this function is a no-op as the complex HISTORYITEM structure
-    // with spCommands makes serialization challenging
+    EngineLock lock;
+
+    HistoryItems items;
+    if (!parse_history_json(json_data, items)) return;
+
+    instance->manager->SetHistory(history_mode_for(instance->currentMode), items);
 }
 
 void calculator_history_clear_for_mode(CalculatorInstance* instance, CalcMode mode) {
     if (!instance || !instance->manager) return;
 
+    EngineLock lock;
+
     CalculationManager::CalculatorMode calcMode;
     switch (mode) {
         case CALC_MODE_STANDARD:
@@ -1018,88 +2769,606 @@ void calculator_history_clear_for_mode(CalculatorInstance* instance, CalcMode mo
             return;
     }
 
-    // Clear history by switching to that mode, clearing, then switching back
-    auto currentMode = instance->currentMode;
+    // Clear history by switching to that mode, clearing, then switching back
+    auto currentMode = instance->currentMode;
+
+    // Temporarily switch to the target mode
+    switch (mode) {
+        case CALC_MODE_STANDARD:
+            instance->manager->SetStandardMode();
+            break;
+        case CALC_MODE_SCIENTIFIC:
+            instance->manager->SetScientificMode();
+            break;
+        case CALC_MODE_PROGRAMMER:
+            instance->manager->SetProgrammerMode();
+            break;
+    }
+
+    // Clear the history
+    instance->manager->ClearHistory();
+
+    // Switch back to the original mode
+    switch (currentMode) {
+        case CALC_MODE_STANDARD:
+            instance->manager->SetStandardMode();
+            break;
+        case CALC_MODE_SCIENTIFIC:
+            instance->manager->SetScientificMode();
+            break;
+        case CALC_MODE_PROGRAMMER:
+            instance->manager->SetProgrammerMode();
+            break;
+    }
+}
+
+// ============================================================================
+// Parenthesis
+// ============================================================================
+
+int calculator_get_parenthesis_count(CalculatorInstance* instance) {
+    if (instance && instance->display) {
+        return static_cast<int>(instance->display->parenthesisCount);
+    }
+    return 0;
+}
+
+// ============================================================================
+// Expression Evaluator Implementation
+// ============================================================================
+
+// Display precision used by CalculatorManager for each mode
+static constexpr int32_t EVAL_STANDARD_PRECISION = 16;
+static constexpr int32_t EVAL_SCIENTIFIC_PRECISION = 32;
+
+// Largest decimal exponent accepted in a literal; beyond this Ratpack would only overflow
+static constexpr int EVAL_MAX_EXPONENT = 10000;
+
+enum EvalOperator {
+    EVAL_OP_NONE,
+    EVAL_OP_ADD,
+    EVAL_OP_SUBTRACT,
+    EVAL_OP_MULTIPLY,
+    EVAL_OP_DIVIDE,
+    EVAL_OP_MOD,
+    EVAL_OP_POWER,
+    EVAL_OP_ROOT
+};
+
+// Ratpack constants are built by the first CCalcEngine. Constructing one engine up
+// front guarantees they exist before any Rational arithmetic runs. Callers hold the
+// engine lock.
+static void ensure_engine_initialized() {
+    struct EngineHost {
+        CalcDisplayImpl display;
+        ResourceProviderImpl resources;
+        CalculationManager::CalculatorManager manager{&display, &resources};
+
+        EngineHost() { manager.SetStandardMode(); }
+    };
+    static EngineHost host;
+}
+
+static CalcEngine::Rational rational_from_digits(std::string_view digits) {
+    CalcEngine::Rational value;
+
+    // Accumulate 18 digits at a time so most literals need a single Rational operation
+    size_t pos = 0;
+    while (pos < digits.size()) {
+        size_t chunk = std::min<size_t>(18, digits.size() - pos);
+        uint64_t part = 0;
+        uint64_t scale = 1;
+        for (size_t i = 0; i < chunk; i++) {
+            part = part * 10 + static_cast<uint64_t>(digits[pos + i] - '0');
+            scale *= 10;
+        }
+        value = value * CalcEngine::Rational(scale) + CalcEngine::Rational(part);
+        pos += chunk;
+    }
+    return value;
+}
+
+static CalcEngine::Rational power_of_ten(int exponent) {
+    CalcEngine::Rational value(static_cast<uint64_t>(1));
+    while (exponent >= 18) {
+        value *= CalcEngine::Rational(static_cast<uint64_t>(1000000000000000000ULL));
+        exponent -= 18;
+    }
+    uint64_t rest = 1;
+    for (int i = 0; i < exponent; i++) {
+        rest *= 10;
+    }
+    return value * CalcEngine::Rational(rest);
+}
+
+// Recursive-descent parser that evaluates while it parses. Operands are Rationals,
+// so results go through the same Ratpack arithmetic as keystroke input.
+class ExpressionEvaluator {
+public:
+    ExpressionEvaluator(std::string_view text, bool scientific)
+        : m_text(text), m_scientific(scientific) {}
+
+    // Returns false on a syntax error; Ratpack math errors propagate as exceptions
+    bool Evaluate(CalcEngine::Rational& result) {
+        if (!ParseExpression(0, result)) return false;
+        SkipSpaces();
+        return m_pos == m_text.size();
+    }
+
+private:
+    std::string_view m_text;
+    size_t m_pos = 0;
+    bool m_scientific;  // Operator precedence and the mod, ^ and yroot keys
+
+    // Matches CCalcEngine::NPrecedenceOfOp
+    int Precedence(EvalOperator op) const {
+        if (!m_scientific) return 0;
+        switch (op) {
+            case EVAL_OP_ADD:
+            case EVAL_OP_SUBTRACT:
+                return 2;
+            case EVAL_OP_MULTIPLY:
+            case EVAL_OP_DIVIDE:
+            case EVAL_OP_MOD:
+                return 3;
+            case EVAL_OP_POWER:
+            case EVAL_OP_ROOT:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    void SkipSpaces() {
+        while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t')) {
+            m_pos++;
+        }
+    }
+
+    bool MatchKeyword(std::string_view keyword, size_t& length) const {
+        if (m_text.size() - m_pos < keyword.size()) return false;
+        for (size_t i = 0; i < keyword.size(); i++) {
+            char c = m_text[m_pos + i];
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            if (c != keyword[i]) return false;
+        }
+        length = keyword.size();
+        return true;
+    }
+
+    EvalOperator PeekOperator(size_t& length) const {
+        if (m_pos >= m_text.size()) return EVAL_OP_NONE;
+
+        length = 1;
+        switch (m_text[m_pos]) {
+            case '+': return EVAL_OP_ADD;
+            case '-': return EVAL_OP_SUBTRACT;
+            case '*': return EVAL_OP_MULTIPLY;
+            case '/': return EVAL_OP_DIVIDE;
+            default: break;
+        }
+
+        // UTF-8 multiplication and division signs as shown in the expression display
+        std::string_view rest = m_text.substr(m_pos);
+        if (rest.substr(0, 2) == "\xC3\x97") { length = 2; return EVAL_OP_MULTIPLY; }
+        if (rest.substr(0, 2) == "\xC3\xB7") { length = 2; return EVAL_OP_DIVIDE; }
+
+        // The standard keypad has no mod, power or root keys
+        if (!m_scientific) return EVAL_OP_NONE;
+
+        if (m_text[m_pos] == '^') return EVAL_OP_POWER;
+        if (MatchKeyword("mod", length)) return EVAL_OP_MOD;
+        if (MatchKeyword("yroot", length)) return EVAL_OP_ROOT;
+
+        return EVAL_OP_NONE;
+    }
+
+    static CalcEngine::Rational Apply(EvalOperator op, const CalcEngine::Rational& lhs, const CalcEngine::Rational& rhs) {
+        switch (op) {
+            case EVAL_OP_ADD:      return lhs + rhs;
+            case EVAL_OP_SUBTRACT: return lhs - rhs;
+            case EVAL_OP_MULTIPLY: return lhs * rhs;
+            case EVAL_OP_DIVIDE:   return lhs / rhs;
+            case EVAL_OP_MOD:      return CalcEngine::RationalMath::Mod(lhs, rhs);
+            case EVAL_OP_POWER:    return CalcEngine::RationalMath::Pow(lhs, rhs);
+            case EVAL_OP_ROOT:     return CalcEngine::RationalMath::Root(lhs, rhs);
+            default:               return lhs;
+        }
+    }
+
+    // Precedence climbing; operators of equal precedence associate left to right
+    bool ParseExpression(int minPrecedence, CalcEngine::Rational& value) {
+        if (!ParseUnary(value)) return false;
+
+        while (true) {
+            SkipSpaces();
+            size_t length = 0;
+            EvalOperator op = PeekOperator(length);
+            if (op == EVAL_OP_NONE || Precedence(op) < minPrecedence) break;
+            m_pos += length;
+
+            CalcEngine::Rational rhs;
+            if (!ParseExpression(m_scientific ? Precedence(op) + 1 : 1, rhs)) return false;
+            value = Apply(op, value, rhs);
+        }
+        return true;
+    }
+
+    bool ParseUnary(CalcEngine::Rational& value) {
+        SkipSpaces();
+        if (m_pos < m_text.size() && (m_text[m_pos] == '-' || m_text[m_pos] == '+')) {
+            bool negate = m_text[m_pos] == '-';
+            m_pos++;
+            if (!ParseUnary(value)) return false;
+            if (negate) value = -value;
+            return true;
+        }
+        return ParsePrimary(value);
+    }
 
-    // Temporarily switch to the target mode
-    switch (mode) {
-        case CALC_MODE_STANDARD:
-            instance->manager->SetStandardMode();
-            break;
-        case CALC_MODE_SCIENTIFIC:
-            instance->manager->SetScientificMode();
-            break;
-        case CALC_MODE_PROGRAMMER:
-            instance->manager->SetProgrammerMode();
-            break;
+    bool ParsePrimary(CalcEngine::Rational& value) {
+        SkipSpaces();
+        if (m_pos >= m_text.size()) return false;
+
+        if (m_text[m_pos] == '(') {
+            m_pos++;
+            if (!ParseExpression(0, value)) return false;
+            SkipSpaces();
+            if (m_pos >= m_text.size() || m_text[m_pos] != ')') return false;
+            m_pos++;
+            return true;
+        }
+
+        return ParseNumber(value);
     }
 
-    // Clear the history
-    instance->manager->ClearHistory();
+    bool ParseNumber(CalcEngine::Rational& value) {
+        std::string digits;
+        int fractionDigits = 0;
+        bool seenDecimal = false;
+
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos];
+            if (c >= '0' && c <= '9') {
+                digits.push_back(c);
+                if (seenDecimal) fractionDigits++;
+            } else if (c == '.' && !seenDecimal) {
+                seenDecimal = true;
+            } else {
+                break;
+            }
+            m_pos++;
+        }
+        if (digits.empty()) return false;
+
+        int exponent = 0;
+        if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+            size_t expPos = m_pos + 1;
+            bool negativeExponent = false;
+            if (expPos < m_text.size() && (m_text[expPos] == '+' || m_text[expPos] == '-')) {
+                negativeExponent = m_text[expPos] == '-';
+                expPos++;
+            }
+            if (expPos >= m_text.size() || m_text[expPos] < '0' || m_text[expPos] > '9') return false;
+            while (expPos < m_text.size() && m_text[expPos] >= '0' && m_text[expPos] <= '9') {
+                exponent = exponent * 10 + (m_text[expPos] - '0');
+                if (exponent > EVAL_MAX_EXPONENT) return false;
+                expPos++;
+            }
+            if (negativeExponent) exponent = -exponent;
+            m_pos = expPos;
+        }
 
-    // Switch back to the original mode
-    switch (currentMode) {
-        case CALC_MODE_STANDARD:
-            instance->manager->SetStandardMode();
-            break;
-        case CALC_MODE_SCIENTIFIC:
-            instance->manager->SetScientificMode();
-            break;
-        case CALC_MODE_PROGRAMMER:
-            instance->manager->SetProgrammerMode();
-            break;
+        value = rational_from_digits(digits);
+        exponent -= fractionDigits;
+        if (exponent > 0) {
+            value *= power_of_ten(exponent);
+        } else if (exponent < 0) {
+            value /= power_of_ten(-exponent);
+        }
+        return true;
     }
-}
+};
 
-// ============================================================================
-// Parenthesis
-// ============================================================================
+int calculator_evaluate(const char* expr, CalcMode mode, char* out, int out_size) {
+    if (!expr) return -1;
 
-int calculator_get_parenthesis_count(CalculatorInstance* instance) {
-    if (instance && instance->display) {
-        return static_cast<int>(instance->display->parenthesisCount);
+    int32_t precision;
+    switch (mode) {
+        case CALC_MODE_STANDARD:   precision = EVAL_STANDARD_PRECISION; break;
+        case CALC_MODE_SCIENTIFIC: precision = EVAL_SCIENTIFIC_PRECISION; break;
+        default:                   return -4;
     }
-    return 0;
+
+    EngineLock lock;
+    ensure_engine_initialized();
+
+    std::wstring result;
+    try {
+        ExpressionEvaluator evaluator(expr, mode == CALC_MODE_SCIENTIFIC);
+        CalcEngine::Rational value;
+        if (!evaluator.Evaluate(value)) return -2;
+        result = value.ToString(10, NumberFormat::Float, precision);
+    } catch (...) {
+        // Ratpack reports division by zero, domain errors and overflow by throwing
+        return -3;
+    }
+
+    return copy_to_buffer(wstring_to_utf8(result), out, out_size);
 }
 
 // ============================================================================
 // Unit Converter Data Loader Implementation
 // ============================================================================
 
+struct CategoryDefinition {
+    int id;
+    const wchar_t* name;
+    bool supportsNegative;
+};
+
+// Units are listed in display order. `factor` converts one unit into the category's base
+// unit; pairwise ratios are derived on demand as factor(from) / factor(to). Categories whose
+// conversions are not a pure scale use a factor of 0 and list their ratios explicitly.
+struct UnitDefinition {
+    int categoryId;
+    int unitId;
+    const wchar_t* name;
+    const wchar_t* abbreviation;
+    double factor;
+    bool isWhimsical;
+};
+
+struct UnitRatioDefinition {
+    int fromUnitId;
+    int toUnitId;
+    double ratio;
+    double offset;
+    bool offsetFirst;
+};
+
+static constexpr CategoryDefinition CATEGORY_DEFINITIONS[] = {
+    {0, L"Length", true},
+    {1, L"Weight and Mass", true},
+    {2, L"Temperature", true},
+    {3, L"Energy", true},
+    {4, L"Area", true},
+    {5, L"Speed", true},
+    {6, L"Time", true},
+    {7, L"Power", true},
+    {8, L"Data", false},
+    {9, L"Pressure", true},
+    {10, L"Angle", true},
+    {11, L"Volume", true},
+};
+
+static constexpr UnitDefinition UNIT_DEFINITIONS[] = {
+    // Length (category 0), factors relative to m
+    {0, 111, L"Angstroms", L"Å", 0.0000000001, false},
+    {0, 105, L"Nanometers", L"nm", 0.000000001, false},
+    {0, 104, L"Micrometers", L"μm", 0.000001, false},
+    {0, 103, L"Millimeters", L"mm", 0.001, false},
+    {0, 102, L"Centimeters", L"cm", 0.01, false},
+    {0, 100, L"Meters", L"m", 1.0, false},
+    {0, 101, L"Kilometers", L"km", 1000.0, false},
+    {0, 109, L"Inches", L"in", 0.0254, false},
+    {0, 108, L"Feet", L"ft", 0.3048, false},
+    {0, 107, L"Yards", L"yd", 0.9144, false},
+    {0, 106, L"Miles", L"mi", 1609.344, false},
+    {0, 110, L"Nautical miles", L"nmi", 1852.0, false},
+    // Whimsical units (at the end)
+    {0, 180, L"Paperclips", L"paperclip", 0.035052, true},                     // Small length unit
+    {0, 181, L"Hands", L"hand", 0.18669, true},                                // Horse height unit
+    {0, 182, L"Jumbo jets", L"jumbo jet", 76.0, true},                         // Large length unit
+
+    // Weight (category 1), factors relative to kg
+    {1, 207, L"Carats", L"ct", 0.0002, false},
+    {1, 202, L"Milligrams", L"mg", 0.000001, false},
+    {1, 208, L"Centigrams", L"cg", 0.00001, false},
+    {1, 209, L"Decigrams", L"dg", 0.0001, false},
+    {1, 201, L"Grams", L"g", 0.001, false},
+    {1, 210, L"Decagrams", L"dag", 0.01, false},
+    {1, 211, L"Hectograms", L"hg", 0.1, false},
+    {1, 200, L"Kilograms", L"kg", 1.0, false},
+    {1, 203, L"Metric tons", L"t", 1000.0, false},
+    {1, 205, L"Ounces", L"oz", 0.028349523125, false},
+    {1, 204, L"Pounds", L"lb", 0.45359237, false},
+    {1, 206, L"Stones", L"st", 6.35029318, false},
+    {1, 212, L"Short tons", L"short ton", 907.18474, false},
+    // Whimsical units (at the end)
+    {1, 280, L"Snowflakes", L"snowflake", 0.000002, true},                     // Very light weight
+    {1, 281, L"Soccer balls", L"soccer ball", 0.4325, true},                   // Sports equipment weight
+    {1, 282, L"Elephants", L"elephant", 4000.0, true},                         // Large animal weight
+    {1, 283, L"Whales", L"whale", 90000.0, true},                              // Very large animal weight
+
+    // Temperature (category 2), see UNIT_RATIO_DEFINITIONS
+    {2, 300, L"Celsius", L"°C", 0.0, false},
+    {2, 301, L"Fahrenheit", L"°F", 0.0, false},
+    {2, 302, L"Kelvin", L"K", 0.0, false},
+
+    // Energy (category 3), factors relative to J
+    {3, 406, L"Electronvolts", L"eV", 0.0000000000000000001602176565, false},
+    {3, 400, L"Joules", L"J", 1.0, false},
+    {3, 401, L"Kilojoules", L"kJ", 1000.0, false},
+    {3, 402, L"Calories", L"cal", 4.184, false},                               // Calories (thermochemical)
+    {3, 403, L"Kilocalories", L"kcal", 4184.0, false},
+    {3, 408, L"Foot-pounds", L"ft-lb", 1.3558179483314, false},
+    {3, 407, L"British thermal units", L"BTU", 1055.056, false},
+    {3, 405, L"Kilowatt-hours", L"kWh", 3600000.0, false},
+    // Whimsical units (at the end)
+    {3, 480, L"Batteries", L"battery", 9000.0, true},                          // AA battery energy
+    {3, 481, L"Bananas", L"banana", 439614.0, true},                           // Food energy
+    {3, 482, L"Slices of cake", L"slice of cake", 1046700.0, true},            // Dessert energy
+
+    // Area (category 4), factors relative to m²
+    {4, 509, L"Square millimeters", L"mm²", 0.000001, false},
+    {4, 502, L"Square centimeters", L"cm²", 0.0001, false},
+    {4, 500, L"Square meters", L"m²", 1.0, false},
+    {4, 503, L"Hectares", L"ha", 10000.0, false},
+    {4, 501, L"Square kilometers", L"km²", 1000000.0, false},
+    {4, 507, L"Square inches", L"in²", 0.00064516, false},
+    {4, 506, L"Square feet", L"ft²", 0.09290304, false},
+    {4, 505, L"Square yards", L"yd²", 0.83612736, false},
+    {4, 508, L"Acres", L"ac", 4046.8564224, false},
+    {4, 504, L"Square miles", L"mi²", 2589988.110336, false},
+    // Whimsical units (at the end)
+    {4, 580, L"Hands", L"hand", 0.012516104, true},                            // Small area unit
+    {4, 581, L"Papers", L"paper", 0.06032246, true},                           // Paper sheet area
+    {4, 582, L"Soccer fields", L"soccer field", 10869.66, true},               // Sports field area
+    {4, 583, L"Castles", L"castle", 100000.0, true},                           // Large building area
+    {4, 584, L"Pyeong", L"pyeong", 400.0 / 121.0, true},                       // Pyeong (~3.30579)
+
+    // Speed (category 5), factors relative to cm/s
+    {5, 606, L"Centimeters per second", L"cm/s", 1.0, false},
+    {5, 600, L"Meters per second", L"m/s", 100.0, false},
+    {5, 601, L"Kilometers per hour", L"km/h", 27.77777777777778, false},
+    {5, 603, L"Feet per second", L"ft/s", 30.48, false},
+    {5, 602, L"Miles per hour", L"mph", 44.704, false},
+    {5, 604, L"Knots", L"kn", 51.444, false},
+    {5, 605, L"Mach", L"Ma", 34030.0, false},
+    // Whimsical units (at the end)
+    {5, 680, L"Turtles", L"turtle", 8.94, true},                               // Slow creature speed
+    {5, 681, L"Horses", L"horse", 2011.5, true},                               // Animal galloping speed
+    {5, 682, L"Jets", L"jet", 24585.0, true},                                  // Aircraft speed
+
+    // Time (category 6), factors relative to s
+    {6, 702, L"Microseconds", L"μs", 0.000001, false},
+    {6, 701, L"Milliseconds", L"ms", 0.001, false},
+    {6, 700, L"Seconds", L"s", 1.0, false},
+    {6, 704, L"Minutes", L"min", 60.0, false},
+    {6, 705, L"Hours", L"h", 3600.0, false},
+    {6, 706, L"Days", L"d", 86400.0, false},
+    {6, 707, L"Weeks", L"wk", 604800.0, false},
+    {6, 708, L"Years", L"yr", 31557600.0, false},                              // Years (using 365.25 days)
+
+    // Power (category 7), factors relative to W
+    {7, 800, L"Watts", L"W", 1.0, false},
+    {7, 801, L"Kilowatts", L"kW", 1000.0, false},
+    {7, 803, L"Horsepower (US)", L"hp", 745.69987158227022, false},            // Horsepower (US)
+    {7, 805, L"Foot-pounds/minute", L"ft-lb/min", 0.0225969658055233, false},
+    {7, 804, L"BTU/minute", L"BTU/min", 17.58426666666667, false},
+    // Whimsical units (at the end)
+    {7, 780, L"Light bulbs", L"light bulb", 60.0, true},                       // Household lighting
+    {7, 781, L"Horses", L"horse", 745.7, true},                                // Animal power
+    {7, 782, L"Train engines", L"train engine", 2982799.486329081, true},      // Locomotive power
+
+    // Data (category 8), factors relative to MB
+    {8, 900, L"Bits", L"b", 0.000000125, false},
+    {8, 899, L"Nibbles", L"Nibble", 0.0000005, false},
+    {8, 901, L"Bytes", L"B", 0.000001, false},
+    {8, 906, L"Kilobits", L"Kb", 0.000125, false},
+    {8, 907, L"Kibibits", L"Kib", 0.000128, false},
+    {8, 896, L"Kilobytes", L"KB", 0.001, false},
+    {8, 897, L"Kibibytes", L"KiB", 0.001024, false},
+    {8, 910, L"Megabits", L"Mb", 0.125, false},
+    {8, 911, L"Mebibits", L"Mib", 0.131072, false},
+    {8, 902, L"Megabytes", L"MB", 1.0, false},
+    {8, 908, L"Mebibytes", L"MiB", 1.048576, false},
+    {8, 912, L"Gigabits", L"Gb", 125.0, false},
+    {8, 909, L"Gibibits", L"Gib", 134.217728, false},
+    {8, 903, L"Gigabytes", L"GB", 1000.0, false},
+    {8, 913, L"Gibibytes", L"GiB", 1073.741824, false},
+    {8, 914, L"Terabits", L"Tb", 125000.0, false},
+    {8, 915, L"Tebibits", L"Tib", 137438.953472, false},
+    {8, 904, L"Terabytes", L"TB", 1000000.0, false},
+    {8, 916, L"Tebibytes", L"TiB", 1099511.627776, false},
+    {8, 917, L"Petabits", L"Pb", 125000000.0, false},
+    {8, 918, L"Pebibits", L"Pib", 140737488.355328, false},
+    {8, 905, L"Petabytes", L"PB", 1000000000.0, false},
+    {8, 919, L"Pebibytes", L"PiB", 1125899906.842624, false},
+    {8, 920, L"Exabits", L"Eb", 125000000000.0, false},
+    {8, 921, L"Exbibits", L"Eib", 144115188075.855872, false},
+    {8, 922, L"Exabytes", L"EB", 1000000000000.0, false},
+    {8, 923, L"Exbibytes", L"EiB", 1152921504606.846976, false},
+    {8, 924, L"Zetabits", L"Zb", 125000000000000.0, false},
+    {8, 925, L"Zebibits", L"Zib", 147573952589676.412928, false},
+    {8, 926, L"Zetabytes", L"ZB", 1000000000000000.0, false},
+    {8, 927, L"Zebibytes", L"ZiB", 1180591620717411.303424, false},
+    {8, 928, L"Yottabits", L"Yb", 125000000000000000.0, false},
+    {8, 929, L"Yobibits", L"Yib", 151115727451828646.838272, false},
+    {8, 930, L"Yottabytes", L"YB", 1000000000000000000.0, false},
+    {8, 931, L"Yobibytes", L"YiB", 1208925819614629174.706176, false},
+    // Whimsical units (at the end)
+    {8, 880, L"Floppy disks", L"floppy disk", 1.474560, true},                 // Floppy disks (whimsical, 1.44 MB)
+    {8, 881, L"CDs", L"CD", 700.0, true},                                      // CDs (whimsical, 700 MB)
+    {8, 882, L"DVDs", L"DVD", 4700.0, true},                                   // DVDs (whimsical, 4.7 GB)
+
+    // Pressure (category 9), factors relative to Pa
+    {9, 1003, L"Atmospheres", L"atm", 101325.0, false},                        // Atmospheres (1 atm = 101325 Pa)
+    {9, 1002, L"Bars", L"bar", 100000.0, false},                               // Bars (1 bar = 100000 Pa)
+    {9, 1001, L"Kilopascals", L"kPa", 1000.0, false},                          // Kilopascals (1 kPa = 1000 Pa)
+    {9, 1005, L"Millimeters of mercury", L"mmHg", 133.322, false},             // Millimeters of mercury (1 mmHg ≈ 133.322 Pa)
+    {9, 1000, L"Pascals", L"Pa", 1.0, false},
+    {9, 1004, L"Pounds per square inch", L"psi", 6894.757, false},             // PSI (1 psi ≈ 6894.757 Pa)
+
+    // Angle (category 10), see UNIT_RATIO_DEFINITIONS
+    {10, 1100, L"Degrees", L"°", 0.0, false},
+    {10, 1101, L"Radians", L"rad", 0.0, false},
+    {10, 1102, L"Gradians", L"grad", 0.0, false},
+
+    // Volume (category 11), factors relative to mL
+    // Metric units first
+    {11, 1201, L"Milliliters", L"mL", 1.0, false},
+    {11, 1203, L"Cubic centimeters", L"cm³", 1.0, false},
+    {11, 1200, L"Liters", L"L", 1000.0, false},
+    {11, 1202, L"Cubic meters", L"m³", 1000000.0, false},
+    // US customary units (cooking measures)
+    {11, 1210, L"Teaspoons (US)", L"tsp", 4.92892159375, false},
+    {11, 1209, L"Tablespoons (US)", L"tbsp", 14.78676478125, false},
+    {11, 1208, L"Fluid ounces (US)", L"fl oz", 29.5735295625, false},
+    {11, 1207, L"Cups (US)", L"cup", 236.588237, false},
+    {11, 1206, L"Pints (US)", L"pt", 473.176473, false},
+    {11, 1205, L"Quarts (US)", L"qt", 946.352946, false},
+    {11, 1204, L"Gallons (US)", L"gal", 3785.411784, false},
+    // US customary units (cubic measures)
+    {11, 1213, L"Cubic inches", L"in³", 16.387064, false},
+    {11, 1212, L"Cubic feet", L"ft³", 28316.846592, false},
+    {11, 1214, L"Cubic yards", L"yd³", 764554.857984, false},
+    // UK imperial units
+    {11, 1216, L"Teaspoons (UK)", L"tsp", 5.91938802083333333333, false},
+    {11, 1217, L"Tablespoons (UK)", L"tbsp", 17.7581640625, false},
+    {11, 1218, L"Fluid ounces (UK)", L"fl oz", 28.4130625, false},
+    {11, 1219, L"Pints (UK)", L"pt", 568.26125, false},
+    {11, 1223, L"Quarts (UK)", L"qt", 1136.5225, false},
+    {11, 1224, L"Gallons (UK)", L"gal", 4546.09, false},
+    // Whimsical units (at the end)
+    {11, 1220, L"Coffee cups", L"coffee cup", 236.5882, true},                 // Small cooking volume
+    {11, 1221, L"Bathtubs", L"bathtub", 378541.2, true},                       // Large volume
+    {11, 1222, L"Swimming pools", L"pool", 3750000000.0, true},                // Very large volume
+};
+
+static constexpr UnitRatioDefinition UNIT_RATIO_DEFINITIONS[] = {
+    // Temperature conversions are offset-based
+    {300, 300, 1.0, 0.0, false},                               // C to C: C = C * 1.0 + 0.0
+    {300, 301, 1.8, 32.0, false},                              // C to F: F = C * 1.8 + 32
+    {300, 302, 1.0, 273.15, false},                            // C to K: K = C + 273.15
+    {301, 300, 1.0/1.8, -32.0/1.8, true},                      // F to C: C = (F - 32) / 1.8
+    {301, 301, 1.0, 0.0, false},                               // F to F: F = F * 1.0 + 0.0
+    {301, 302, 0.55555555555555555555555555555556, 459.67, true}, // F to K: K = (F + 459.67) / 1.8
+    {302, 300, 1.0, -273.15, false},                           // K to C: C = K - 273.15
+    {302, 301, 1.8, -459.67, false},                           // K to F: F = K * 1.8 - 459.67
+    {302, 302, 1.0, 0.0, false},                               // K to K: K = K * 1.0 + 0.0
+
+    // Angle
+    {1100, 1101, 0.0174533, 0.0, false},
+    {1100, 1102, 1.11111, 0.0, false},
+};
+
 class UnitConverterDataLoader : public UnitConversionManager::IConverterDataLoader {
 public:
     void LoadData() override {
         if (m_loaded) return;
 
-        // Define categories
-        m_categories = {
-            {0, L"Length", true},
-            {1, L"Weight and Mass", true},
-            {2, L"Temperature", true},
-            {3, L"Energy", true},
-            {4, L"Area", true},
-            {5, L"Speed", true},
-            {6, L"Time", true},
-            {7, L"Power", true},
-            {8, L"Data", false},
-            {9, L"Pressure", true},
-            {10, L"Angle", true},
-            {11, L"Volume", true},
-        };
-
-        // Define units for each category
-        initLengthUnits();
-        initWeightUnits();
-        initTemperatureUnits();
-        initEnergyUnits();
-        initAreaUnits();
-        initSpeedUnits();
-        initTimeUnits();
-        initPowerUnits();
-        initDataUnits();
-        initPressureUnits();
-        initAngleUnits();
-        initVolumeUnits();
+        for (const auto& category : CATEGORY_DEFINITIONS) {
+            m_categories.push_back({category.id, category.name, category.supportsNegative});
+        }
+
+        // One pass over the static table; no ratios are materialised here
+        for (const auto& definition : UNIT_DEFINITIONS) {
+            UnitConversionManager::Unit unit(definition.unitId, definition.name, definition.abbreviation, true, true, definition.isWhimsical);
+            m_categoryUnits[definition.categoryId].push_back(unit);
+            m_unitById[definition.unitId] = {unit, &definition};
+        }
 
         m_loaded = true;
     }
@@ -1118,11 +3387,32 @@ public:
 
     std::unordered_map<UnitConversionManager::Unit, UnitConversionManager::ConversionData, UnitConversionManager::UnitHash>
     LoadOrderedRatios(const UnitConversionManager::Unit& u) override {
-        auto it = m_ratios.find(u.id);
-        if (it != m_ratios.end()) {
-            return it->second;
+        std::unordered_map<UnitConversionManager::Unit, UnitConversionManager::ConversionData, UnitConversionManager::UnitHash> ratios;
+
+        // Called on the shared catalog by every converter, so only const lookups here
+        auto from = m_unitById.find(u.id);
+        if (from == m_unitById.end()) return ratios;
+
+        if (from->second.definition->factor != 0.0) {
+            auto units = m_categoryUnits.find(from->second.definition->categoryId);
+            if (units == m_categoryUnits.end()) return ratios;
+
+            for (const auto& to : units->second) {
+                UnitConversionManager::ConversionData data;
+                FindRatio(u.id, to.id, &data);
+                ratios[to] = data;
+            }
+        } else {
+            for (const auto& ratio : UNIT_RATIO_DEFINITIONS) {
+                if (ratio.fromUnitId != u.id) continue;
+
+                const UnitConversionManager::Unit* to = FindUnit(ratio.toUnitId);
+                if (to) {
+                    ratios[*to] = UnitConversionManager::ConversionData(ratio.ratio, ratio.offset, ratio.offsetFirst);
+                }
+            }
         }
-        return {};
+        return ratios;
     }
 
     bool SupportsCategory(const UnitConversionManager::Category& target) override {
@@ -1132,489 +3422,65 @@ public:
         return false;
     }
 
-private:
-    bool m_loaded = false;
-    std::vector<UnitConversionManager::Category> m_categories;
-    std::unordered_map<int, std::vector<UnitConversionManager::Unit>> m_categoryUnits;
-    std::unordered_map<int, std::unordered_map<UnitConversionManager::Unit, UnitConversionManager::ConversionData, UnitConversionManager::UnitHash>> m_ratios;
-    std::unordered_map<int, UnitConversionManager::Unit> m_unitById; // Map unit ID to complete Unit object
-
-    void addUnit(int categoryId, int unitId, const std::wstring& name, const std::wstring& abbr, bool isWhimsical = false) {
-        UnitConversionManager::Unit unit(unitId, name, abbr, true, true, isWhimsical);
-        m_categoryUnits[categoryId].push_back(unit);
-        m_unitById[unitId] = unit; // Store complete unit object
-    }
-
-    void addRatio(int fromUnitId, int toUnitId, double ratio, double offset = 0.0, bool offsetFirst = false) {
-        // Use complete Unit objects from m_unitById instead of creating empty ones
-        // The structure is: m_ratios[fromUnitId][toUnit] = conversionData
-        m_ratios[fromUnitId][m_unitById[toUnitId]] = UnitConversionManager::ConversionData(ratio, offset, offsetFirst);
-    }
-
-    // Helper function to automatically add bidirectional conversions between all units in a category
-    // based on conversion factors to a base unit (like the original Windows Calculator implementation)
-    void addBidirectionalConversions(int categoryId, std::vector<std::pair<int, double>> unitFactors) {
-        // unitFactors: vector of (unitId, factorToBaseUnit)
-        // For each pair of units, calculate the conversion ratio: factor_A / factor_B
-        for (size_t i = 0; i < unitFactors.size(); i++) {
-            for (size_t j = 0; j < unitFactors.size(); j++) {
-                int fromUnitId = unitFactors[i].first;
-                int toUnitId = unitFactors[j].first;
-                double fromFactor = unitFactors[i].second;
-                double toFactor = unitFactors[j].second;
-
-                if (i == j) {
-                    // Same unit: add identity conversion (ratio = 1.0)
-                    addRatio(fromUnitId, toUnitId, 1.0);
-                } else {
-                    // Different units: calculate conversion ratio
-                    double ratio = fromFactor / toFactor;
-                    addRatio(fromUnitId, toUnitId, ratio);
-                }
+    // Read-only accessors for the shared catalog. Apart from LoadData, which runs once
+    // before the catalog is shared, no method modifies it, so all are safe from any thread.
+    const std::vector<UnitConversionManager::Category>& Categories() const {
+        return m_categories;
+    }
+
+    const UnitConversionManager::Unit* FindUnit(int unitId) const {
+        auto it = m_unitById.find(unitId);
+        return it != m_unitById.end() ? &it->second.unit : nullptr;
+    }
+
+    // Look up the conversion from one unit to another; returns false if there is none
+    bool FindRatio(int fromUnitId, int toUnitId, UnitConversionManager::ConversionData* data) const {
+        auto from = m_unitById.find(fromUnitId);
+        auto to = m_unitById.find(toUnitId);
+        if (from == m_unitById.end() || to == m_unitById.end()) return false;
+
+        const UnitDefinition* fromDefinition = from->second.definition;
+        const UnitDefinition* toDefinition = to->second.definition;
+        if (fromDefinition->factor != 0.0 && toDefinition->factor != 0.0) {
+            if (fromDefinition->categoryId != toDefinition->categoryId) return false;
+
+            double ratio = fromUnitId == toUnitId ? 1.0 : fromDefinition->factor / toDefinition->factor;
+            *data = UnitConversionManager::ConversionData(ratio, 0.0, false);
+            return true;
+        }
+
+        for (const auto& ratio : UNIT_RATIO_DEFINITIONS) {
+            if (ratio.fromUnitId == fromUnitId && ratio.toUnitId == toUnitId) {
+                *data = UnitConversionManager::ConversionData(ratio.ratio, ratio.offset, ratio.offsetFirst);
+                return true;
             }
         }
+        return false;
     }
 
-    void initLengthUnits() {
-        // Length units (category 0) - Reordered to user's specification
-        addUnit(0, 111, L"Angstroms", L"Å");
-        addUnit(0, 105, L"Nanometers", L"nm");
-        addUnit(0, 104, L"Micrometers", L"μm");
-        addUnit(0, 103, L"Millimeters", L"mm");
-        addUnit(0, 102, L"Centimeters", L"cm");
-        addUnit(0, 100, L"Meters", L"m");
-        addUnit(0, 101, L"Kilometers", L"km");
-        addUnit(0, 109, L"Inches", L"in");
-        addUnit(0, 108, L"Feet", L"ft");
-        addUnit(0, 107, L"Yards", L"yd");
-        addUnit(0, 106, L"Miles", L"mi");
-        addUnit(0, 110, L"Nautical miles", L"nmi");
-
-        // Whimsical units (at the end)
-        addUnit(0, 180, L"Paperclips", L"paperclip", true);       // Small length unit
-        addUnit(0, 181, L"Hands", L"hand", true);                 // Horse height unit
-        addUnit(0, 182, L"Jumbo jets", L"jumbo jet", true);       // Large length unit
-
-        // Use automatic bidirectional conversion based on factors to meters (base unit)
-        // Factors are relative to meters: 1 m = 1.0, 1 km = 1000 m, etc.
-        std::vector<std::pair<int, double>> lengthFactors;
-        lengthFactors.push_back(std::make_pair(111, 0.0000000001)); // Angstroms
-        lengthFactors.push_back(std::make_pair(105, 0.000000001));  // Nanometers
-        lengthFactors.push_back(std::make_pair(104, 0.000001));     // Micrometers
-        lengthFactors.push_back(std::make_pair(103, 0.001));        // Millimeters
-        lengthFactors.push_back(std::make_pair(102, 0.01));         // Centimeters
-        lengthFactors.push_back(std::make_pair(100, 1.0));          // Meters (base)
-        lengthFactors.push_back(std::make_pair(101, 1000.0));       // Kilometers
-        lengthFactors.push_back(std::make_pair(109, 0.0254));       // Inches
-        lengthFactors.push_back(std::make_pair(108, 0.3048));       // Feet
-        lengthFactors.push_back(std::make_pair(107, 0.9144));       // Yards
-        lengthFactors.push_back(std::make_pair(106, 1609.344));     // Miles
-        lengthFactors.push_back(std::make_pair(110, 1852.0));       // Nautical miles
-        lengthFactors.push_back(std::make_pair(180, 0.035052));     // Paperclips
-        lengthFactors.push_back(std::make_pair(181, 0.18669));      // Hands
-        lengthFactors.push_back(std::make_pair(182, 76.0));         // Jumbo jets
-        addBidirectionalConversions(0, lengthFactors);
-    }
-
-    void initWeightUnits() {
-        // Weight units (category 1) - Reordered to user's specification
-        addUnit(1, 207, L"Carats", L"ct");
-        addUnit(1, 202, L"Milligrams", L"mg");
-        addUnit(1, 208, L"Centigrams", L"cg");
-        addUnit(1, 209, L"Decigrams", L"dg");
-        addUnit(1, 201, L"Grams", L"g");
-        addUnit(1, 210, L"Decagrams", L"dag");
-        addUnit(1, 211, L"Hectograms", L"hg");
-        addUnit(1, 200, L"Kilograms", L"kg");
-        addUnit(1, 203, L"Metric tons", L"t");
-        addUnit(1, 205, L"Ounces", L"oz");
-        addUnit(1, 204, L"Pounds", L"lb");
-        addUnit(1, 206, L"Stones", L"st");
-        addUnit(1, 212, L"Short tons", L"short ton");
-
-        // Whimsical units (at the end)
-        addUnit(1, 280, L"Snowflakes", L"snowflake", true);       // Very light weight
-        addUnit(1, 281, L"Soccer balls", L"soccer ball", true);   // Sports equipment weight
-        addUnit(1, 282, L"Elephants", L"elephant", true);         // Large animal weight
-        addUnit(1, 283, L"Whales", L"whale", true);               // Very large animal weight
-
-        // Use automatic bidirectional conversion based on factors to kilograms (base unit)
-        std::vector<std::pair<int, double>> weightFactors;
-        weightFactors.push_back(std::make_pair(207, 0.0002));        // Carats
-        weightFactors.push_back(std::make_pair(202, 0.000001));     // Milligrams
-        weightFactors.push_back(std::make_pair(208, 0.00001));      // Centigrams
-        weightFactors.push_back(std::make_pair(209, 0.0001));       // Decigrams
-        weightFactors.push_back(std::make_pair(201, 0.001));        // Grams
-        weightFactors.push_back(std::make_pair(210, 0.01));         // Decagrams
-        weightFactors.push_back(std::make_pair(211, 0.1));          // Hectograms
-        weightFactors.push_back(std::make_pair(200, 1.0));          // Kilograms (base)
-        weightFactors.push_back(std::make_pair(203, 1000.0));       // Metric tons
-        weightFactors.push_back(std::make_pair(205, 0.028349523125)); // Ounces
-        weightFactors.push_back(std::make_pair(204, 0.45359237));   // Pounds
-        weightFactors.push_back(std::make_pair(206, 6.35029318));   // Stones
-        weightFactors.push_back(std::make_pair(212, 907.18474));    // Short tons
-        weightFactors.push_back(std::make_pair(280, 0.000002));     // Snowflakes
-        weightFactors.push_back(std::make_pair(281, 0.4325));       // Soccer balls
-        weightFactors.push_back(std::make_pair(282, 4000.0));       // Elephants
-        weightFactors.push_back(std::make_pair(283, 90000.0));      // Whales
-        addBidirectionalConversions(1, weightFactors);
-    }
-
-    void initTemperatureUnits() {
-        // Temperature units (category 2) - Reordered to match source
-        addUnit(2, 300, L"Celsius", L"°C");
-        addUnit(2, 301, L"Fahrenheit", L"°F");
-        addUnit(2, 302, L"Kelvin", L"K");
-
-        // Temperature conversions are special (offset-based)
-        addRatio(300, 300, 1.0, 0.0, false);  // C to C: C = C * 1.0 + 0.0
-        addRatio(300, 301, 1.8, 32.0, false);    // C to F: F = C * 1.8 + 32
-        addRatio(300, 302, 1.0, 273.15, false);  // C to K: K = C + 273.15
-        addRatio(301, 300, 1.0/1.8, -32.0/1.8, true); // F to C: C = (F - 32) / 1.8
-        addRatio(301, 301, 1.0, 0.0, false);  // F to F: F = F * 1.0 + 0.0
-        addRatio(301, 302, 0.55555555555555555555555555555556, 459.67, true); // F to K: K = (F + 459.67) / 1.8
-        addRatio(302, 300, 1.0, -273.15, false); // K to C: C = K - 273.15
-        addRatio(302, 301, 1.8, -459.67, false); // K to F: F = K * 1.8 - 459.67
-        addRatio(302, 302, 1.0, 0.0, false);  // K to K: K = K * 1.0 + 0.0
-    }
-
-    void initEnergyUnits() {
-        // Energy units (category 3) - Reordered to match source
-        addUnit(3, 406, L"Electronvolts", L"eV");
-        addUnit(3, 400, L"Joules", L"J");
-        addUnit(3, 401, L"Kilojoules", L"kJ");
-        addUnit(3, 402, L"Calories", L"cal");
-        addUnit(3, 403, L"Kilocalories", L"kcal");
-        addUnit(3, 408, L"Foot-pounds", L"ft-lb");
-        addUnit(3, 407, L"British thermal units", L"BTU");
-        addUnit(3, 405, L"Kilowatt-hours", L"kWh");
-
-        // Whimsical units (at the end)
-        addUnit(3, 480, L"Batteries", L"battery", true);         // AA battery energy
-        addUnit(3, 481, L"Bananas", L"banana", true);            // Food energy
-        addUnit(3, 482, L"Slices of cake", L"slice of cake", true); // Dessert energy
-
-        // Use automatic bidirectional conversion based on factors to Joules (base unit)
-        // Factors are relative to Joules: 1 J = 1.0, etc.
-        std::vector<std::pair<int, double>> energyFactors;
-        energyFactors.push_back(std::make_pair(406, 0.0000000000000000001602176565)); // Electronvolts
-        energyFactors.push_back(std::make_pair(400, 1.0));          // Joules (base)
-        energyFactors.push_back(std::make_pair(401, 1000.0));       // Kilojoules
-        energyFactors.push_back(std::make_pair(402, 4.184));        // Calories (thermochemical)
-        energyFactors.push_back(std::make_pair(403, 4184.0));       // Kilocalories
-        energyFactors.push_back(std::make_pair(408, 1.3558179483314)); // Foot-pounds
-        energyFactors.push_back(std::make_pair(407, 1055.056));     // British thermal units
-        energyFactors.push_back(std::make_pair(405, 3600000.0));    // Kilowatt-hours
-        energyFactors.push_back(std::make_pair(480, 9000.0));       // Batteries (whimsical)
-        energyFactors.push_back(std::make_pair(481, 439614.0));     // Bananas (whimsical)
-        energyFactors.push_back(std::make_pair(482, 1046700.0));    // Slices of cake (whimsical)
-        addBidirectionalConversions(3, energyFactors);
-    }
-
-    void initAreaUnits() {
-        // Area units (category 4) - Reordered to match source
-        addUnit(4, 509, L"Square millimeters", L"mm²");
-        addUnit(4, 502, L"Square centimeters", L"cm²");
-        addUnit(4, 500, L"Square meters", L"m²");
-        addUnit(4, 503, L"Hectares", L"ha");
-        addUnit(4, 501, L"Square kilometers", L"km²");
-        addUnit(4, 507, L"Square inches", L"in²");
-        addUnit(4, 506, L"Square feet", L"ft²");
-        addUnit(4, 505, L"Square yards", L"yd²");
-        addUnit(4, 508, L"Acres", L"ac");
-        addUnit(4, 504, L"Square miles", L"mi²");
-
-        // Whimsical units (at the end)
-        addUnit(4, 580, L"Hands", L"hand", true);              // Small area unit
-        addUnit(4, 581, L"Papers", L"paper", true);             // Paper sheet area
-        addUnit(4, 582, L"Soccer fields", L"soccer field", true); // Sports field area
-        addUnit(4, 583, L"Castles", L"castle", true);           // Large building area
-        addUnit(4, 584, L"Pyeong", L"pyeong", true);           // Korean/Japanese floor area
-
-        // Use automatic bidirectional conversion (factors to square meters as base)
-        std::vector<std::pair<int, double>> areaFactors;
-        areaFactors.push_back(std::make_pair(509, 0.000001));    // Square millimeters
-        areaFactors.push_back(std::make_pair(502, 0.0001));      // Square centimeters
-        areaFactors.push_back(std::make_pair(500, 1.0));         // Square meters (base)
-        areaFactors.push_back(std::make_pair(503, 10000.0));     // Hectares
-        areaFactors.push_back(std::make_pair(501, 1000000.0));   // Square kilometers
-        areaFactors.push_back(std::make_pair(507, 0.00064516));   // Square inches
-        areaFactors.push_back(std::make_pair(506, 0.09290304));   // Square feet
-        areaFactors.push_back(std::make_pair(505, 0.83612736));   // Square yards
-        areaFactors.push_back(std::make_pair(508, 4046.8564224)); // Acres
-        areaFactors.push_back(std::make_pair(504, 2589988.110336)); // Square miles
-        areaFactors.push_back(std::make_pair(580, 0.012516104));  // Hands
-        areaFactors.push_back(std::make_pair(581, 0.06032246));   // Papers
-        areaFactors.push_back(std::make_pair(582, 10869.66));     // Soccer fields
-        areaFactors.push_back(std::make_pair(583, 100000.0));     // Castles
-        areaFactors.push_back(std::make_pair(584, 400.0 / 121.0)); // Pyeong (~3.30579)
-        addBidirectionalConversions(4, areaFactors);
-    }
-
-    void initSpeedUnits() {
-        // Speed units (category 5) - Reordered to match source
-        addUnit(5, 606, L"Centimeters per second", L"cm/s");
-        addUnit(5, 600, L"Meters per second", L"m/s");
-        addUnit(5, 601, L"Kilometers per hour", L"km/h");
-        addUnit(5, 603, L"Feet per second", L"ft/s");
-        addUnit(5, 602, L"Miles per hour", L"mph");
-        addUnit(5, 604, L"Knots", L"kn");
-        addUnit(5, 605, L"Mach", L"Ma");
-
-        // Whimsical units (at the end)
-        addUnit(5, 680, L"Turtles", L"turtle", true);            // Slow creature speed
-        addUnit(5, 681, L"Horses", L"horse", true);              // Animal galloping speed
-        addUnit(5, 682, L"Jets", L"jet", true);                  // Aircraft speed
-
-        // Use automatic bidirectional conversion (factors to m/s as base)
-        // Factors are from original Windows Calculator code (m/s = 100 as base)
-        std::vector<std::pair<int, double>> speedFactors;
-        speedFactors.push_back(std::make_pair(606, 1.0));        // cm/s
-        speedFactors.push_back(std::make_pair(600, 100.0));      // m/s (base)
-        speedFactors.push_back(std::make_pair(601, 27.77777777777778)); // km/h
-        speedFactors.push_back(std::make_pair(603, 30.48));      // ft/s
-        speedFactors.push_back(std::make_pair(602, 44.704));     // mph
-        speedFactors.push_back(std::make_pair(604, 51.444));     // knots
-        speedFactors.push_back(std::make_pair(605, 34030.0));     // Mach
-        speedFactors.push_back(std::make_pair(680, 8.94));       // Turtles (whimsical)
-        speedFactors.push_back(std::make_pair(681, 2011.5));     // Horses (whimsical)
-        speedFactors.push_back(std::make_pair(682, 24585.0));    // Jets (whimsical)
-        addBidirectionalConversions(5, speedFactors);
-    }
-
-    void initTimeUnits() {
-        // Time units (category 6) - Reordered to match source
-        addUnit(6, 702, L"Microseconds", L"μs");
-        addUnit(6, 701, L"Milliseconds", L"ms");
-        addUnit(6, 700, L"Seconds", L"s");
-        addUnit(6, 704, L"Minutes", L"min");
-        addUnit(6, 705, L"Hours", L"h");
-        addUnit(6, 706, L"Days", L"d");
-        addUnit(6, 707, L"Weeks", L"wk");
-        addUnit(6, 708, L"Years", L"yr");
-
-        // Use automatic bidirectional conversion (factors to seconds as base)
-        std::vector<std::pair<int, double>> timeFactors;
-        timeFactors.push_back(std::make_pair(702, 0.000001));     // Microseconds
-        timeFactors.push_back(std::make_pair(701, 0.001));        // Milliseconds
-        timeFactors.push_back(std::make_pair(700, 1.0));           // Seconds (base)
-        timeFactors.push_back(std::make_pair(704, 60.0));         // Minutes
-        timeFactors.push_back(std::make_pair(705, 3600.0));       // Hours
-        timeFactors.push_back(std::make_pair(706, 86400.0));      // Days
-        timeFactors.push_back(std::make_pair(707, 604800.0));     // Weeks
-        timeFactors.push_back(std::make_pair(708, 31557600.0));   // Years (using 365.25 days)
-        addBidirectionalConversions(6, timeFactors);
-    }
-
-    void initPowerUnits() {
-        // Power units (category 7) - Reordered to match source
-        addUnit(7, 800, L"Watts", L"W");
-        addUnit(7, 801, L"Kilowatts", L"kW");
-        addUnit(7, 803, L"Horsepower (US)", L"hp");
-        addUnit(7, 805, L"Foot-pounds/minute", L"ft-lb/min");
-        addUnit(7, 804, L"BTU/minute", L"BTU/min");
-
-        // Whimsical units (at the end)
-        addUnit(7, 780, L"Light bulbs", L"light bulb", true);     // Household lighting
-        addUnit(7, 781, L"Horses", L"horse", true);               // Animal power
-        addUnit(7, 782, L"Train engines", L"train engine", true); // Locomotive power
-
-        // Use automatic bidirectional conversion (factors to Watts as base)
-        std::vector<std::pair<int, double>> powerFactors;
-        powerFactors.push_back(std::make_pair(800, 1.0));         // Watts (base)
-        powerFactors.push_back(std::make_pair(801, 1000.0));      // Kilowatts
-        powerFactors.push_back(std::make_pair(803, 745.69987158227022)); // Horsepower (US)
-        powerFactors.push_back(std::make_pair(805, 0.0225969658055233)); // Foot-pounds/minute
-        powerFactors.push_back(std::make_pair(804, 17.58426666666667)); // BTU/min
-        powerFactors.push_back(std::make_pair(780, 60.0));        // Light bulbs (whimsical)
-        powerFactors.push_back(std::make_pair(781, 745.7));       // Horses (whimsical)
-        powerFactors.push_back(std::make_pair(782, 2982799.486329081)); // Train engines (whimsical)
-        addBidirectionalConversions(7, powerFactors);
-    }
-
-    void initDataUnits() {
-        // Data units (category 8) - Reordered to user's specification
-        addUnit(8, 900, L"Bits", L"b");
-        addUnit(8, 899, L"Nibbles", L"Nibble");
-        addUnit(8, 901, L"Bytes", L"B");
-        addUnit(8, 906, L"Kilobits", L"Kb");
-        addUnit(8, 907, L"Kibibits", L"Kib");
-        addUnit(8, 896, L"Kilobytes", L"KB");
-        addUnit(8, 897, L"Kibibytes", L"KiB");
-        addUnit(8, 910, L"Megabits", L"Mb");
-        addUnit(8, 911, L"Mebibits", L"Mib");
-        addUnit(8, 902, L"Megabytes", L"MB");
-        addUnit(8, 908, L"Mebibytes", L"MiB");
-        addUnit(8, 912, L"Gigabits", L"Gb");
-        addUnit(8, 909, L"Gibibits", L"Gib");
-        addUnit(8, 903, L"Gigabytes", L"GB");
-        addUnit(8, 913, L"Gibibytes", L"GiB");
-        addUnit(8, 914, L"Terabits", L"Tb");
-        addUnit(8, 915, L"Tebibits", L"Tib");
-        addUnit(8, 904, L"Terabytes", L"TB");
-        addUnit(8, 916, L"Tebibytes", L"TiB");
-        addUnit(8, 917, L"Petabits", L"Pb");
-        addUnit(8, 918, L"Pebibits", L"Pib");
-        addUnit(8, 905, L"Petabytes", L"PB");
-        addUnit(8, 919, L"Pebibytes", L"PiB");
-        addUnit(8, 920, L"Exabits", L"Eb");
-        addUnit(8, 921, L"Exbibits", L"Eib");
-        addUnit(8, 922, L"Exabytes", L"EB");
-        addUnit(8, 923, L"Exbibytes", L"EiB");
-        addUnit(8, 924, L"Zetabits", L"Zb");
-        addUnit(8, 925, L"Zebibits", L"Zib");
-        addUnit(8, 926, L"Zetabytes", L"ZB");
-        addUnit(8, 927, L"Zebibytes", L"ZiB");
-        addUnit(8, 928, L"Yottabits", L"Yb");
-        addUnit(8, 929, L"Yobibits", L"Yib");
-        addUnit(8, 930, L"Yottabytes", L"YB");
-        addUnit(8, 931, L"Yobibytes", L"YiB");
-
-        // Whimsical units (at the end)
-        addUnit(8, 880, L"Floppy disks", L"floppy disk", true);   // Legacy storage
-        addUnit(8, 881, L"CDs", L"CD", true);                     // Optical media
-        addUnit(8, 882, L"DVDs", L"DVD", true);                   // Optical storage
-
-        // Use automatic bidirectional conversion based on factors to Megabytes (base unit for display)
-        // Factors are relative to Megabytes: 1 MB = 1.0, etc.
-        std::vector<std::pair<int, double>> dataFactors;
-        dataFactors.push_back(std::make_pair(900, 0.000000125));  // Bits
-        dataFactors.push_back(std::make_pair(899, 0.0000005));     // Nibbles
-        dataFactors.push_back(std::make_pair(901, 0.000001));      // Bytes
-        dataFactors.push_back(std::make_pair(906, 0.000125));      // Kilobits
-        dataFactors.push_back(std::make_pair(907, 0.000128));      // Kibibits
-        dataFactors.push_back(std::make_pair(896, 0.001));         // Kilobytes
-        dataFactors.push_back(std::make_pair(897, 0.001024));      // Kibibytes
-        dataFactors.push_back(std::make_pair(910, 0.125));         // Megabits
-        dataFactors.push_back(std::make_pair(911, 0.131072));      // Mebibits
-        dataFactors.push_back(std::make_pair(902, 1.0));           // Megabytes (base)
-        dataFactors.push_back(std::make_pair(908, 1.048576));      // Mebibytes
-        dataFactors.push_back(std::make_pair(912, 125.0));         // Gigabits
-        dataFactors.push_back(std::make_pair(909, 134.217728));    // Gibibits
-        dataFactors.push_back(std::make_pair(903, 1000.0));        // Gigabytes
-        dataFactors.push_back(std::make_pair(913, 1073.741824));   // Gibibytes
-        dataFactors.push_back(std::make_pair(914, 125000.0));      // Terabits
-        dataFactors.push_back(std::make_pair(915, 137438.953472)); // Tebibits
-        dataFactors.push_back(std::make_pair(904, 1000000.0));     // Terabytes
-        dataFactors.push_back(std::make_pair(916, 1099511.627776)); // Tebibytes
-        dataFactors.push_back(std::make_pair(917, 125000000.0));   // Petabits
-        dataFactors.push_back(std::make_pair(918, 140737488.355328)); // Pebibits
-        dataFactors.push_back(std::make_pair(905, 1000000000.0));  // Petabytes
-        dataFactors.push_back(std::make_pair(919, 1125899906.842624)); // Pebibytes
-        dataFactors.push_back(std::make_pair(920, 125000000000.0)); // Exabits
-        dataFactors.push_back(std::make_pair(921, 144115188075.855872)); // Exbibits
-        dataFactors.push_back(std::make_pair(922, 1000000000000.0)); // Exabytes
-        dataFactors.push_back(std::make_pair(923, 1152921504606.846976)); // Exbibytes
-        dataFactors.push_back(std::make_pair(924, 125000000000000.0)); // Zetabits
-        dataFactors.push_back(std::make_pair(925, 147573952589676.412928)); // Zebibits
-        dataFactors.push_back(std::make_pair(926, 1000000000000000.0)); // Zetabytes
-        dataFactors.push_back(std::make_pair(927, 1180591620717411.303424)); // Zebibytes
-        dataFactors.push_back(std::make_pair(928, 125000000000000000.0)); // Yottabits
-        dataFactors.push_back(std::make_pair(929, 151115727451828646.838272)); // Yobibits
-        dataFactors.push_back(std::make_pair(930, 1000000000000000000.0)); // Yottabytes
-        dataFactors.push_back(std::make_pair(931, 1208925819614629174.706176)); // Yobibytes
-        dataFactors.push_back(std::make_pair(880, 1.474560));      // Floppy disks (whimsical, 1.44 MB)
-        dataFactors.push_back(std::make_pair(881, 700.0));         // CDs (whimsical, 700 MB)
-        dataFactors.push_back(std::make_pair(882, 4700.0));        // DVDs (whimsical, 4.7 GB)
-        addBidirectionalConversions(8, dataFactors);
-    }
-
-    void initPressureUnits() {
-        // Pressure units (category 9) - Reordered to match source
-        addUnit(9, 1003, L"Atmospheres", L"atm");
-        addUnit(9, 1002, L"Bars", L"bar");
-        addUnit(9, 1001, L"Kilopascals", L"kPa");
-        addUnit(9, 1005, L"Millimeters of mercury", L"mmHg");
-        addUnit(9, 1000, L"Pascals", L"Pa");
-        addUnit(9, 1004, L"Pounds per square inch", L"psi");
-
-        // Use automatic bidirectional conversion based on factors to Pascals (base unit)
-        // Factors are relative to Pascals: 1 Pa = 1.0
-        std::vector<std::pair<int, double>> pressureFactors;
-        pressureFactors.push_back(std::make_pair(1003, 101325.0));      // Atmospheres (1 atm = 101325 Pa)
-        pressureFactors.push_back(std::make_pair(1002, 100000.0));      // Bars (1 bar = 100000 Pa)
-        pressureFactors.push_back(std::make_pair(1001, 1000.0));        // Kilopascals (1 kPa = 1000 Pa)
-        pressureFactors.push_back(std::make_pair(1005, 133.322));       // Millimeters of mercury (1 mmHg ≈ 133.322 Pa)
-        pressureFactors.push_back(std::make_pair(1000, 1.0));           // Pascals (base)
-        pressureFactors.push_back(std::make_pair(1004, 6894.757));      // PSI (1 psi ≈ 6894.757 Pa)
-        addBidirectionalConversions(9, pressureFactors);
-    }
-
-    void initAngleUnits() {
-        // Angle units (category 10) - Reordered to user's specification
-        addUnit(10, 1100, L"Degrees", L"°");
-        addUnit(10, 1101, L"Radians", L"rad");
-        addUnit(10, 1102, L"Gradians", L"grad");
-
-        addRatio(1100, 1101, 0.0174533);
-        addRatio(1100, 1102, 1.11111);
-    }
-
-    void initVolumeUnits() {
-        // Volume units (category 11) - Reordered to user's specification
-        // Metric units first
-        addUnit(11, 1201, L"Milliliters", L"mL");
-        addUnit(11, 1203, L"Cubic centimeters", L"cm³");
-        addUnit(11, 1200, L"Liters", L"L");
-        addUnit(11, 1202, L"Cubic meters", L"m³");
-
-        // US customary units (cooking measures)
-        addUnit(11, 1210, L"Teaspoons (US)", L"tsp");
-        addUnit(11, 1209, L"Tablespoons (US)", L"tbsp");
-        addUnit(11, 1208, L"Fluid ounces (US)", L"fl oz");
-        addUnit(11, 1207, L"Cups (US)", L"cup");
-        addUnit(11, 1206, L"Pints (US)", L"pt");
-        addUnit(11, 1205, L"Quarts (US)", L"qt");
-        addUnit(11, 1204, L"Gallons (US)", L"gal");
-
-        // US customary units (cubic measures)
-        addUnit(11, 1213, L"Cubic inches", L"in³");
-        addUnit(11, 1212, L"Cubic feet", L"ft³");
-        addUnit(11, 1214, L"Cubic yards", L"yd³");
-
-        // UK imperial units
-        addUnit(11, 1216, L"Teaspoons (UK)", L"tsp");
-        addUnit(11, 1217, L"Tablespoons (UK)", L"tbsp");
-        addUnit(11, 1218, L"Fluid ounces (UK)", L"fl oz");
-        addUnit(11, 1219, L"Pints (UK)", L"pt");
-        addUnit(11, 1223, L"Quarts (UK)", L"qt");
-        addUnit(11, 1224, L"Gallons (UK)", L"gal");
-
-        // Whimsical units (at the end)
-        addUnit(11, 1220, L"Coffee cups", L"coffee cup", true);     // Small cooking volume
-        addUnit(11, 1221, L"Bathtubs", L"bathtub", true);             // Large volume
-        addUnit(11, 1222, L"Swimming pools", L"pool", true);          // Very large volume
-
-        // Use automatic bidirectional conversion based on factors to cubic centimeters (base unit)
-        // Factors are from original Windows Calculator code (cm³ = 1 as base)
-        std::vector<std::pair<int, double>> volumeFactors;
-        volumeFactors.push_back(std::make_pair(1201, 1.0));           // Milliliters (base)
-        volumeFactors.push_back(std::make_pair(1203, 1.0));           // Cubic centimeters
-        volumeFactors.push_back(std::make_pair(1200, 1000.0));        // Liters
-        volumeFactors.push_back(std::make_pair(1202, 1000000.0));     // Cubic meters
-        volumeFactors.push_back(std::make_pair(1210, 4.92892159375)); // US teaspoons
-        volumeFactors.push_back(std::make_pair(1209, 14.78676478125));// US tablespoons
-        volumeFactors.push_back(std::make_pair(1208, 29.5735295625)); // US fluid ounces
-        volumeFactors.push_back(std::make_pair(1207, 236.588237));    // US cups
-        volumeFactors.push_back(std::make_pair(1206, 473.176473));    // US pints
-        volumeFactors.push_back(std::make_pair(1205, 946.352946));    // US quarts
-        volumeFactors.push_back(std::make_pair(1204, 3785.411784));   // US gallons
-        volumeFactors.push_back(std::make_pair(1213, 16.387064));     // Cubic inches
-        volumeFactors.push_back(std::make_pair(1212, 28316.846592));  // Cubic feet
-        volumeFactors.push_back(std::make_pair(1214, 764554.857984)); // Cubic yards
-        volumeFactors.push_back(std::make_pair(1216, 5.91938802083333333333)); // UK teaspoons
-        volumeFactors.push_back(std::make_pair(1217, 17.7581640625)); // UK tablespoons
-        volumeFactors.push_back(std::make_pair(1218, 28.4130625));    // UK fluid ounces
-        volumeFactors.push_back(std::make_pair(1219, 568.26125));     // UK pints
-        volumeFactors.push_back(std::make_pair(1223, 1136.5225));     // UK quarts
-        volumeFactors.push_back(std::make_pair(1224, 4546.09));       // UK gallons
-        volumeFactors.push_back(std::make_pair(1220, 236.5882));      // Coffee cups (whimsical)
-        volumeFactors.push_back(std::make_pair(1221, 378541.2));      // Bathtubs (whimsical)
-        volumeFactors.push_back(std::make_pair(1222, 3750000000.0));  // Swimming pools (whimsical)
-        addBidirectionalConversions(11, volumeFactors);
-    }
+private:
+    struct UnitEntry {
+        UnitConversionManager::Unit unit;
+        const UnitDefinition* definition = nullptr;
+    };
+
+    bool m_loaded = false;
+    std::vector<UnitConversionManager::Category> m_categories;
+    std::unordered_map<int, std::vector<UnitConversionManager::Unit>> m_categoryUnits;
+    std::unordered_map<int, UnitEntry> m_unitById;
 };
 
+// The catalog is immutable once loaded, so a single instance is built on first use
+// (thread-safe static initialization) and shared by every UnitConverterInstance
+static std::shared_ptr<UnitConverterDataLoader> shared_unit_catalog() {
+    static const std::shared_ptr<UnitConverterDataLoader> catalog = [] {
+        auto loader = std::make_shared<UnitConverterDataLoader>();
+        loader->LoadData();
+        return loader;
+    }();
+    return catalog;
+}
+
 // ============================================================================
 // Unit Converter VM Callback Implementation
 // ============================================================================
@@ -1642,9 +3508,8 @@ public:
 
 struct UnitConverterInstance {
     std::shared_ptr<UnitConversionManager::UnitConverter> converter;
-    std::shared_ptr<UnitConverterDataLoader> dataLoader;
+    std::shared_ptr<UnitConverterDataLoader> dataLoader;  // Shared, read-only catalog
     std::shared_ptr<UnitConverterVMCallbackImpl> callback;
-    std::vector<UnitConversionManager::Category> categories;
     std::vector<UnitConversionManager::Unit> currentUnits;
     int currentCategoryId = -1;
     int fromUnitId = -1;
@@ -1658,19 +3523,18 @@ struct UnitConverterInstance {
 UnitConverterInstance* unit_converter_create(void) {
     auto instance = new UnitConverterInstance();
 
-    instance->dataLoader = std::make_shared<UnitConverterDataLoader>();
+    instance->dataLoader = shared_unit_catalog();
     instance->callback = std::make_shared<UnitConverterVMCallbackImpl>();
     instance->converter = std::make_shared<UnitConversionManager::UnitConverter>(instance->dataLoader);
 
     instance->converter->Initialize();
     instance->converter->SetViewModelCallback(instance->callback);
 
-    instance->categories = instance->converter->GetCategories();
-
     // Set default category
-    if (!instance->categories.empty()) {
-        instance->currentCategoryId = instance->categories[0].id;
-        auto [units, fromUnit, toUnit] = instance->converter->SetCurrentCategory(instance->categories[0]);
+    const auto& categories = instance->dataLoader->Categories();
+    if (!categories.empty()) {
+        instance->currentCategoryId = categories[0].id;
+        auto [units, fromUnit, toUnit] = instance->converter->SetCurrentCategory(categories[0]);
         instance->currentUnits = units;
         instance->fromUnitId = fromUnit.id;
         instance->toUnitId = toUnit.id;
@@ -1685,31 +3549,31 @@ void unit_converter_destroy(UnitConverterInstance* instance) {
 
 int unit_converter_get_category_count(UnitConverterInstance* instance) {
     if (instance) {
-        return static_cast<int>(instance->categories.size());
+        return static_cast<int>(instance->dataLoader->Categories().size());
     }
     return 0;
 }
 
 int unit_converter_get_category_name(UnitConverterInstance* instance, int index, char* buffer, int buffer_size) {
-    if (!instance || index < 0 || index >= static_cast<int>(instance->categories.size())) {
+    if (!instance || index < 0 || index >= static_cast<int>(instance->dataLoader->Categories().size())) {
         return -1;
     }
 
-    std::string utf8 = wstring_to_utf8(instance->categories[index].name);
+    std::string utf8 = wstring_to_utf8(instance->dataLoader->Categories()[index].name);
     return copy_to_buffer(utf8, buffer, buffer_size);
 }
 
 int unit_converter_get_category_id(UnitConverterInstance* instance, int index) {
-    if (!instance || index < 0 || index >= static_cast<int>(instance->categories.size())) {
+    if (!instance || index < 0 || index >= static_cast<int>(instance->dataLoader->Categories().size())) {
         return -1;
     }
-    return instance->categories[index].id;
+    return instance->dataLoader->Categories()[index].id;
 }
 
 void unit_converter_set_category(UnitConverterInstance* instance, int category_id) {
     if (!instance || !instance->converter) return;
 
-    for (const auto& cat : instance->categories) {
+    for (const auto& cat : instance->dataLoader->Categories()) {
         if (cat.id == category_id) {
             instance->currentCategoryId = category_id;
             auto [units, fromUnit, toUnit] = instance->converter->SetCurrentCategory(cat);
@@ -1888,7 +3752,7 @@ void calculator_free(CalculatorInstance* instance) {
 
 int calculator_get_result_length(CalculatorInstance* instance) {
     if (!instance || !instance->display) return -1;
-    return static_cast<int>(wstring_to_utf8(instance->display->primaryDisplay).length());
+    return static_cast<int>(instance->display->PrimaryDisplayUtf8().length());
 }
 
 int calculator_get_result(CalculatorInstance* instance, char* buffer, int buffer_size) {
@@ -1942,6 +3806,146 @@ int unit_converter_get_suggested_value(UnitConverterInstance* instance, int inde
     return unit.id;
 }
 
+// ============================================================================
+// Direct Unit Conversion
+// ============================================================================
+
+// Same formula as UnitConverter::Convert
+static double apply_conversion(const UnitConversionManager::ConversionData& data, double value) {
+    return data.offsetFirst ? (value + data.offset) * data.ratio : value * data.ratio + data.offset;
+}
+
+int unit_converter_convert_value(int from_unit_id, int to_unit_id, double value, double* out) {
+    if (!out) return 0;
+
+    UnitConversionManager::ConversionData data;
+    if (!shared_unit_catalog()->FindRatio(from_unit_id, to_unit_id, &data)) return 0;
+
+    *out = apply_conversion(data, value);
+    return 1;
+}
+
+int unit_converter_convert_array(int from_unit_id, int to_unit_id, const double* in, double* out, size_t count) {
+    if ((!in || !out) && count > 0) return 0;
+
+    UnitConversionManager::ConversionData data;
+    if (!shared_unit_catalog()->FindRatio(from_unit_id, to_unit_id, &data)) return 0;
+
+    // Separate multiply and add (never fused) so every lane rounds like apply_conversion
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256d ratio = _mm256_set1_pd(data.ratio);
+    const __m256d offset = _mm256_set1_pd(data.offset);
+    if (data.offsetFirst) {
+        for (; i + 4 <= count; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_add_pd(_mm256_loadu_pd(in + i), offset), ratio));
+        }
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i), ratio), offset));
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128d ratio = _mm_set1_pd(data.ratio);
+    const __m128d offset = _mm_set1_pd(data.offset);
+    if (data.offsetFirst) {
+        for (; i + 2 <= count; i += 2) {
+            _mm_storeu_pd(out + i, _mm_mul_pd(_mm_add_pd(_mm_loadu_pd(in + i), offset), ratio));
+        }
+    } else {
+        for (; i + 2 <= count; i += 2) {
+            _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), ratio), offset));
+        }
+    }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    const float64x2_t ratio = vdupq_n_f64(data.ratio);
+    const float64x2_t offset = vdupq_n_f64(data.offset);
+    if (data.offsetFirst) {
+        for (; i + 2 <= count; i += 2) {
+            vst1q_f64(out + i, vmulq_f64(vaddq_f64(vld1q_f64(in + i), offset), ratio));
+        }
+    } else {
+        for (; i + 2 <= count; i += 2) {
+            vst1q_f64(out + i, vaddq_f64(vmulq_f64(vld1q_f64(in + i), ratio), offset));
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = apply_conversion(data, in[i]);
+    }
+    return 1;
+}
+
+// Same limits UnitConverter::Calculate uses for the "to" display
+static constexpr int CONVERTER_MAX_DIGITS = 15;
+static constexpr int CONVERTER_OPTIMAL_DIGITS = 7;
+static constexpr double CONVERTER_OPTIMAL_DECIMAL = 1e-6;
+static constexpr double CONVERTER_MIN_DECIMAL = 1e-14;
+
+static void trim_trailing_zeros(std::string& text) {
+    size_t point = text.find('.');
+    if (point == std::string::npos) return;
+
+    size_t last = text.find_last_not_of('0');
+    text.erase(last == point ? point : last + 1);
+}
+
+// Formats a conversion result the way UnitConverter::Calculate does, so the direct path
+// and the keystroke path print the same string. `inputDigits` is the number of digits the
+// user supplied, which widens the fixed-point precision like a typed value would.
+static std::string format_converted_value(double value, int inputDigits) {
+    std::ostringstream output;
+    output.imbue(std::locale::classic());
+
+    int preDecimal = value == 0.0 ? 1 : 1 + static_cast<int>(std::max(0.0, std::log10(std::abs(value))));
+    if (preDecimal > CONVERTER_MAX_DIGITS || (value != 0.0 && std::abs(value) < CONVERTER_MIN_DECIMAL)) {
+        output << std::scientific << value;
+        std::string text = output.str();
+        size_t exponent = text.find('e');
+        std::string mantissa = text.substr(0, exponent);
+        trim_trailing_zeros(mantissa);
+        return mantissa + text.substr(exponent);
+    }
+
+    int precision = CONVERTER_MAX_DIGITS;
+    if (std::abs(value) >= CONVERTER_OPTIMAL_DECIMAL) {
+        int significant = std::max(CONVERTER_OPTIMAL_DIGITS, std::min(CONVERTER_MAX_DIGITS, inputDigits));
+        precision = std::max(0, significant - preDecimal);
+    }
+
+    output << std::fixed;
+    output.precision(precision);
+    output << value;
+    std::string text = output.str();
+    trim_trailing_zeros(text);
+    return text;
+}
+
+int unit_converter_convert(int from_unit_id, int to_unit_id, const char* value, char* out, int out_size) {
+    if (!value) return -1;
+
+    UnitConversionManager::ConversionData data;
+    if (!shared_unit_catalog()->FindRatio(from_unit_id, to_unit_id, &data)) return -1;
+
+    // Parse and format with the classic locale so '.' is always the decimal separator
+    std::istringstream input(value);
+    input.imbue(std::locale::classic());
+    double number = 0.0;
+    if (!(input >> number) || !(input >> std::ws).eof()) return -2;
+
+    double result = apply_conversion(data, number);
+    if (!std::isfinite(result)) return -2;
+
+    // Count the mantissa digits the caller supplied, as GetNumberDigits does for typed input
+    int inputDigits = 0;
+    for (const char* c = value; *c && *c != 'e' && *c != 'E'; c++) {
+        if (*c >= '0' && *c <= '9') inputDigits++;
+    }
+
+    return copy_to_buffer(format_converted_value(result, inputDigits), out, out_size);
+}
+
 // ============================================================================
 // Bit Position Toggle Command Helper
 // ============================================================================
@@ -2041,3 +4045,365 @@ void calculator_set_all_callbacks(CalculatorInstance* instance, const CalcDispla
     instance->onMemoryItemChanged = callbacks->onMemoryItemChanged;
     instance->onInputChanged = callbacks->onInputChanged;
 }
+
+// ============================================================================
+// Display Event Queue Functions
+// ============================================================================
+
+int calculator_enable_event_queue(CalculatorInstance* instance, int capacity) {
+    if (!instance || capacity < 0) return 0;
+
+    if (capacity == 0) {
+        instance->eventQueue.reset();
+        return 1;
+    }
+
+    size_t size = EVENT_QUEUE_MIN_CAPACITY;
+    while (size < static_cast<size_t>(capacity) && size < EVENT_QUEUE_MAX_CAPACITY) {
+        size <<= 1;
+    }
+    instance->eventQueue = std::make_unique<EventQueue>(size);
+    return 1;
+}
+
+int calculator_drain_events(CalculatorInstance* instance, void* buffer, int buffer_size) {
+    if (!instance || !instance->eventQueue) return 0;
+    if (!buffer) buffer_size = 0;
+    if (buffer_size < 0) return 0;
+
+    size_t required = 0;
+    size_t written = instance->eventQueue->Drain(static_cast<char*>(buffer), static_cast<size_t>(buffer_size), required);
+    return required > 0 ? -static_cast<int>(required) : static_cast<int>(written);
+}
+
+int calculator_get_dropped_event_count(CalculatorInstance* instance) {
+    if (!instance || !instance->eventQueue) return 0;
+
+    return static_cast<int>(instance->eventQueue->TakeDroppedCount());
+}
+
+// ============================================================================
+// Callback Coalescing
+// ============================================================================
+
+void calculator_set_callback_coalescing(CalculatorInstance* instance, int enabled) {
+    if (instance) {
+        instance->coalesceCallbacks = enabled != 0;
+    }
+}
+
+// ============================================================================
+// Instance Pool
+// ============================================================================
+
+struct CalculatorPool {
+    std::mutex mutex;
+    std::vector<CalculatorInstance*> idle;
+    std::unordered_set<CalculatorInstance*> inUse;  // Handed out and not yet released
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Return a released instance to the state calculator_create produces. Word width and
+// angle type live in the programmer and scientific engines, so those are only visited
+// when a setting differs from the default, and standard mode is only selected again when
+// another mode was left active.
+static void reset_pooled_instance(CalculatorInstance* instance) {
+    EngineLock lock;
+    static const CalcDisplayCallbacks noCallbacks = {};
+    calculator_set_all_callbacks(instance, &noCallbacks);
+    instance->callbackUserData = nullptr;
+    instance->eventQueue.reset();
+    instance->coalesceCallbacks = false;
+
+    if (instance->currentWordType != CALC_WORD_QWORD) {
+        calculator_set_programmer_mode(instance);
+        calculator_set_word_width(instance, CALC_WORD_QWORD);
+    }
+    if (instance->currentAngleType != CALC_ANGLE_DEGREES) {
+        calculator_set_scientific_mode(instance);
+        calculator_set_angle_type(instance, CALC_ANGLE_DEGREES);
+    }
+    if (instance->currentMode != CALC_MODE_STANDARD) {
+        calculator_set_standard_mode(instance);
+    }
+
+    instance->manager->Reset(true);
+    instance->memoryTerms.clear();
+    for (auto mode : {CalculationManager::CalculatorMode::Standard, CalculationManager::CalculatorMode::Scientific}) {
+        if (!instance->manager->GetHistoryItems(mode).empty()) {
+            instance->manager->SetHistory(mode, {});
+        }
+    }
+    instance->currentRadix = CALC_RADIX_DECIMAL;
+    instance->carryFlag = 0;
+    instance->isInHistoryLoadMode = false;
+
+    // Start the next user's expression diff from the cleared display
+    CalcExpressionDiff diff;
+    instance->display->TakeExpressionDiff(diff);
+}
+
+CalculatorPool* calculator_pool_create(int initial_size) {
+    if (initial_size < 0) return nullptr;
+
+    auto pool = new CalculatorPool();
+    pool->idle.reserve(static_cast<size_t>(initial_size));
+    for (int i = 0; i < initial_size; i++) {
+        pool->idle.push_back(calculator_create());
+    }
+    return pool;
+}
+
+void calculator_pool_destroy(CalculatorPool* pool) {
+    if (!pool) return;
+
+    for (CalculatorInstance* instance : pool->idle) {
+        calculator_destroy(instance);
+    }
+    delete pool;
+}
+
+CalculatorInstance* calculator_pool_acquire(CalculatorPool* pool) {
+    if (!pool) return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->idle.empty()) {
+            CalculatorInstance* instance = pool->idle.back();
+            pool->idle.pop_back();
+            pool->inUse.insert(instance);
+            pool->hits++;
+            return instance;
+        }
+        pool->misses++;
+    }
+
+    // Build outside the lock so a miss does not stall other threads
+    CalculatorInstance* instance = calculator_create();
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->inUse.insert(instance);
+    return instance;
+}
+
+int calculator_pool_release(CalculatorPool* pool, CalculatorInstance* instance) {
+    if (!pool || !instance) return -1;
+
+    // Only instances this pool handed out are taken back, once each
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (pool->inUse.erase(instance) == 0) return -1;
+    }
+
+    reset_pooled_instance(instance);
+
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->idle.push_back(instance);
+    return 0;
+}
+
+void calculator_pool_get_stats(CalculatorPool* pool, CalcPoolStats* stats) {
+    if (!pool || !stats) return;
+
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    stats->idle = static_cast<uint64_t>(pool->idle.size());
+    stats->in_use = static_cast<uint64_t>(pool->inUse.size());
+}
+
+// ============================================================================
+// Batch Evaluation
+// ============================================================================
+
+// Jobs are split into one contiguous range per worker. A worker claims indices from its own
+// range and, once that is exhausted, steals from the other ranges, so uneven job costs
+// still keep every worker busy.
+struct BatchRange {
+    alignas(64) std::atomic<size_t> next{0};
+    size_t end = 0;
+};
+
+// Commands that change a setting or toggle the engine keeps across a clear
+static bool changes_engine_setting(CalculatorCommand command) {
+    return (command >= CMD_HEX && command <= CMD_GRAD) || command == CMD_HYP || command == CMD_INV ||
+           command == CMD_FE;
+}
+
+// Each worker keeps one calculator per mode for as long as the process runs. Between
+// command jobs the calculator is cleared in its own mode; only a job that changed a
+// setting pays for the full reset_pooled_instance and mode switch.
+class BatchWorker {
+public:
+    void Run(const CalcJob* jobs, CalcResult* results, std::vector<BatchRange>& ranges, size_t home,
+             std::atomic<size_t>& succeeded) {
+        size_t done = 0;
+        for (size_t offset = 0; offset < ranges.size(); offset++) {
+            BatchRange& range = ranges[(home + offset) % ranges.size()];
+            for (size_t index = range.next.fetch_add(1); index < range.end; index = range.next.fetch_add(1)) {
+                if (RunJob(jobs[index], results[index])) done++;
+            }
+        }
+        succeeded.fetch_add(done);
+    }
+
+private:
+    CalculatorInstance* m_instances[3] = {};  // Created on first use, one per mode
+
+    bool RunJob(const CalcJob& job, CalcResult& result) {
+        result.status = -1;
+        result.length = 0;
+        result.text[0] = '\0';
+        if (job.mode < CALC_MODE_STANDARD || job.mode > CALC_MODE_PROGRAMMER) return false;
+        CalcMode mode = static_cast<CalcMode>(job.mode);
+
+        if (job.type == CALC_JOB_EXPRESSION) {
+            if (!job.expression) return false;
+            int length = calculator_evaluate(job.expression, mode, result.text, sizeof(result.text));
+            result.status = length < 0 ? length : 0;
+            result.length = length < 0 ? 0 : length;
+            if (length < 0) result.text[0] = '\0';
+            return length >= 0;
+        }
+
+        if (job.type != CALC_JOB_COMMANDS || job.command_count < 0 || (!job.commands && job.command_count > 0)) {
+            return false;
+        }
+
+        CalculatorInstance* instance = Instance(mode);
+        EngineLock lock;
+        calculator_send_commands(instance, job.commands, job.command_count);
+        result.status = instance->display->hasError ? 1 : 0;
+        result.length = copy_to_buffer(instance->display->PrimaryDisplayUtf8(), result.text, sizeof(result.text));
+        Clear(instance, mode, job);
+        return result.status == 0;
+    }
+
+    // Leave the calculator as calculator_create would, already in `mode`
+    static void Clear(CalculatorInstance* instance, CalcMode mode, const CalcJob& job) {
+        if (std::any_of(job.commands, job.commands + job.command_count, changes_engine_setting) ||
+            instance->currentMode != mode) {
+            reset_pooled_instance(instance);
+            SelectMode(instance, mode);
+            return;
+        }
+
+        instance->manager->SendCommand(static_cast<CalculationManager::Command>(CMD_CLEAR));
+        if (!instance->display->memorizedNumbers.empty()) instance->manager->MemorizedNumberClearAll();
+        instance->memoryTerms.clear();
+        if (mode != CALC_MODE_PROGRAMMER && !instance->manager->GetHistoryItems().empty()) {
+            instance->manager->ClearHistory();
+        }
+        instance->carryFlag = 0;
+        instance->isInHistoryLoadMode = false;
+    }
+
+    static void SelectMode(CalculatorInstance* instance, CalcMode mode) {
+        if (mode == CALC_MODE_SCIENTIFIC) calculator_set_scientific_mode(instance);
+        if (mode == CALC_MODE_PROGRAMMER) calculator_set_programmer_mode(instance);
+    }
+
+    CalculatorInstance* Instance(CalcMode mode) {
+        CalculatorInstance*& instance = m_instances[mode];
+        if (!instance) {
+            instance = calculator_create();
+            SelectMode(instance, mode);
+        }
+        return instance;
+    }
+};
+
+// Process-wide batch workers. Threads are started on demand, then wait for the next batch
+// instead of exiting; worker 0 is driven by the calling thread. The pool is never
+// destroyed, so its threads and calculators live until the process exits.
+class BatchPool {
+public:
+    static BatchPool& Get() {
+        static BatchPool* pool = new BatchPool();
+        return *pool;
+    }
+
+    size_t Run(const CalcJob* jobs, size_t count, CalcResult* results, size_t workers) {
+        // One batch at a time: the workers and their calculators are shared by all callers
+        std::lock_guard<std::mutex> batchLock(m_batchMutex);
+
+        std::vector<BatchRange> ranges(workers);
+        for (size_t i = 0; i < workers; i++) {
+            ranges[i].next.store(count * i / workers);
+            ranges[i].end = count * (i + 1) / workers;
+        }
+        std::atomic<size_t> succeeded{0};
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (m_workers.size() < workers) {
+                m_workers.push_back(std::make_unique<BatchWorker>());
+                if (m_workers.size() > 1) {
+                    std::thread(&BatchPool::ThreadMain, this, m_workers.size() - 1).detach();
+                }
+            }
+            m_jobs = jobs;
+            m_results = results;
+            m_ranges = &ranges;
+            m_succeeded = &succeeded;
+            m_active = workers;
+            m_running = workers - 1;
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        m_workers[0]->Run(jobs, results, ranges, 0, succeeded);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_running == 0; });
+        return succeeded.load();
+    }
+
+private:
+    std::mutex m_batchMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::vector<std::unique_ptr<BatchWorker>> m_workers;
+
+    // The current batch, published under m_mutex with a new generation
+    uint64_t m_generation = 0;
+    size_t m_active = 0;   // Workers taking part
+    size_t m_running = 0;  // Pool threads still working on it
+    const CalcJob* m_jobs = nullptr;
+    CalcResult* m_results = nullptr;
+    std::vector<BatchRange>* m_ranges = nullptr;
+    std::atomic<size_t>* m_succeeded = nullptr;
+
+    void ThreadMain(size_t index) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_generation != seen; });
+            seen = m_generation;
+            if (index >= m_active) continue;
+
+            BatchWorker& worker = *m_workers[index];
+            const CalcJob* jobs = m_jobs;
+            CalcResult* results = m_results;
+            std::vector<BatchRange>& ranges = *m_ranges;
+            std::atomic<size_t>& succeeded = *m_succeeded;
+            lock.unlock();
+            worker.Run(jobs, results, ranges, index, succeeded);
+            lock.lock();
+            if (--m_running == 0) m_done.notify_one();
+        }
+    }
+};
+
+int calculator_evaluate_batch(const CalcJob* jobs, size_t count, CalcResult* out, int threads) {
+    if ((!jobs || !out) && count > 0) return -1;
+    if (count > static_cast<size_t>(INT_MAX)) return -1;  // The success count must fit the return value
+    if (count == 0) return 0;
+
+    // More threads than cores only adds contention, so requests are capped at the core count
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t workers = threads > 0 ? std::min(static_cast<size_t>(threads), cores) : cores;
+    workers = std::min(workers, count);
+    return static_cast<int>(BatchPool::Get().Run(jobs, count, out, workers));
+}
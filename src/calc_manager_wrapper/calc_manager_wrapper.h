@@ -19,6 +19,7 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 // ============================================================================
@@ -30,6 +31,15 @@ typedef int32_t CalculatorCommand;
 // Opaque pointer types
 typedef struct CalculatorInstance CalculatorInstance;
 typedef struct UnitConverterInstance UnitConverterInstance;
+typedef struct CalculatorPool CalculatorPool;
+
+// String getters
+// Every function that fills a caller-provided (char* buffer, int buffer_size) pair follows
+// an snprintf-like contract: it returns the full UTF-8 length of the value (excluding the
+// terminator) and writes at most buffer_size - 1 bytes plus a NUL terminator.
+// A NULL buffer or buffer_size <= 0 is a pure length query; a return value >= buffer_size
+// means the output was truncated. Negative values signal invalid arguments.
+// unit_converter_get_suggested_value is the exception: it returns the unit ID.
 
 // ============================================================================
 // Calculator Commands - Numbers
@@ -271,9 +281,26 @@ typedef enum {
 // ============================================================================
 
 // Lifecycle
+// Threading: each instance must be used by one thread at a time, but different instances
+// may be driven from different threads. CalcManager keeps Ratpack's constants and
+// precision in process-wide state, so engine work is serialized internally. Display
+// callbacks run on the calling thread after that internal lock is released, just before
+// the call that raised them returns, so a callback never holds up other threads.
 CALC_API CalculatorInstance* calculator_create(void);
 CALC_API void calculator_destroy(CalculatorInstance* instance);
 
+// Locale pack: UTF-8 separators used by instances created afterwards.
+// `grouping` uses the Windows LOCALE_SGROUPING form, e.g. "3;0" or "3;2;0".
+// NULL fields (or a NULL locale) restore the defaults ".", "," and "3;0".
+// Existing instances keep the locale they were created with.
+typedef struct {
+    const char* decimal_separator;
+    const char* grouping_separator;
+    const char* grouping;
+} CalcLocale;
+
+CALC_API void calculator_set_locale(const CalcLocale* locale);
+
 // History load mode management
 CALC_API int calculator_is_in_history_load_mode(CalculatorInstance* instance);
 CALC_API void calculator_set_history_load_mode(CalculatorInstance* instance, int enabled);
@@ -287,11 +314,69 @@ CALC_API int calculator_get_current_mode(CalculatorInstance* instance);
 // Commands
 CALC_API void calculator_send_command(CalculatorInstance* instance, CalculatorCommand command);
 
+// Batched commands: applies `count` commands in a single call.
+// Display callbacks are deferred while the batch runs. When it completes, discrete events
+// (history item added, memory item changed, ...) are delivered in the order they occurred,
+// then the final primary display, expression and parenthesis count are reported once.
+// Returns the index of the first command that put the calculator into an error state
+// (an error already present before the batch is not counted), `count` if no command
+// did, or -1 on invalid arguments.
+CALC_API int calculator_send_commands(CalculatorInstance* instance, const CalculatorCommand* commands, int count);
+
 // Results
 CALC_API int calculator_get_primary_display(CalculatorInstance* instance, char* buffer, int buffer_size);
 CALC_API int calculator_get_expression(CalculatorInstance* instance, char* buffer, int buffer_size);
 CALC_API int calculator_has_error(CalculatorInstance* instance);
 
+// Zero-copy access to the display state (UTF-8, NUL-terminated).
+// The returned pointer is owned by the instance and stays valid until the next call
+// that mutates the instance. `len` is optional and receives the length in bytes.
+// Returns NULL if the instance is invalid.
+CALC_API const char* calculator_peek_primary_display(CalculatorInstance* instance, int* len);
+CALC_API const char* calculator_peek_expression(CalculatorInstance* instance, int* len);
+
+// Incremental expression display.
+// The expression is a list of tokens; calculator_get_expression() joins them, each
+// followed by a space. calculator_get_expression_diff() reports how the list changed
+// since the previous diff call (or since creation): the `removed_count` tokens starting
+// at `index` were replaced by the `inserted_count` tokens now at that index, so hosts
+// can patch their rendering instead of rebuilding it.
+typedef struct {
+    int32_t index;
+    int32_t removed_count;
+    int32_t inserted_count;
+    int32_t token_count;  // Current number of tokens
+} CalcExpressionDiff;
+
+// Returns 1 if the expression changed, 0 if not (diff is then empty at token_count), -1 on invalid arguments
+CALC_API int calculator_get_expression_diff(CalculatorInstance* instance, CalcExpressionDiff* diff);
+CALC_API int calculator_get_expression_token_count(CalculatorInstance* instance);
+// Text of one token without the separating space; -1 if index is out of range
+CALC_API int calculator_get_expression_token(CalculatorInstance* instance, int index, char* buffer, int buffer_size);
+
+// Structured expression tokens.
+// Token kinds follow the engine's expression commands; CALC_TOKEN_TEXT covers tokens
+// that were not rendered from a command.
+typedef enum {
+    CALC_TOKEN_UNARY = 0,        // command: the function, e.g. CMD_SIN
+    CALC_TOKEN_BINARY = 1,       // command: the operator, e.g. CMD_ADD
+    CALC_TOKEN_OPERAND = 2,      // command: -1
+    CALC_TOKEN_PARENTHESIS = 3,  // command: CMD_OPENP or CMD_CLOSEP
+    CALC_TOKEN_TEXT = 4          // command: -1
+} CalcTokenType;
+
+typedef struct {
+    int32_t type;      // CalcTokenType
+    int32_t command;   // CalculatorCommand, or -1
+    const char* text;  // UTF-8, not NUL-terminated
+    int32_t length;    // Length of text in bytes
+} CalcToken;
+
+// Fills up to `max` tokens and returns the total token count (call with max = 0 to size
+// the array). All `text` slices point into one instance-owned buffer that stays valid
+// until the next call that mutates the instance. Returns -1 on invalid arguments.
+CALC_API int calculator_get_expression_tokens(CalculatorInstance* instance, CalcToken* out, int max);
+
 // State
 CALC_API void calculator_reset(CalculatorInstance* instance, int clear_memory);
 CALC_API int calculator_is_input_empty(CalculatorInstance* instance);
@@ -310,9 +395,38 @@ CALC_API int calculator_get_result_dec(CalculatorInstance* instance, char* buffe
 CALC_API int calculator_get_result_oct(CalculatorInstance* instance, char* buffer, int buffer_size);
 CALC_API int calculator_get_result_bin(CalculatorInstance* instance, char* buffer, int buffer_size);
 
-// Binary representation for bit panel (64 chars: '0' or '1')
+// Binary representation for bit panel (64 chars: '0' or '1', needs a 65-byte buffer)
 CALC_API int calculator_get_binary_display(CalculatorInstance* instance, char* buffer, int buffer_size);
 
+// Every programmer-panel representation of the current value, NUL-terminated and grouped
+// like calculator_get_result_* (hex/bin in 4s, oct in 3s, dec with the locale's thousands
+// separator and grouping pattern)
+typedef struct CalcRadixSnapshot {
+    uint64_t value;   // Two's-complement value at the current word width
+    char hex[24];
+    char dec[32];
+    char oct[32];
+    char bin[80];
+    char bits[65];    // Same as calculator_get_binary_display
+} CalcRadixSnapshot;
+
+// Fill `snapshot` from a single read of the current value. Returns 1 when the value was
+// read as an integer, 0 when the strings had to be fetched per radix instead (not in
+// programmer mode, or in an error state; `value` is then 0), -1 on invalid arguments,
+// and -2 if any string did not fit its field (it is cut off but still NUL-terminated).
+CALC_API int calculator_get_all_radix_results(CalculatorInstance* instance, CalcRadixSnapshot* snapshot);
+
+// Current value as raw two's-complement bits (bit n = CMD_BINPOS(n)), plus the active
+// word width in bits (8, 16, 32 or 64). Either output may be NULL. Returns 1 on success,
+// 0 outside programmer mode or while the display shows an error.
+CALC_API int calculator_get_value_bits(CalculatorInstance* instance, uint64_t* bits, int* word_width);
+
+// Toggle every bit set in `mask` (bits beyond the word width are ignored) as one display
+// update: the new value replaces the current entry as if typed in the current radix, and
+// notifications are delivered once. Returns 1 on success, 0 outside programmer mode or
+// while the display shows an error.
+CALC_API int calculator_toggle_bits(CalculatorInstance* instance, uint64_t mask);
+
 // Word size (for programmer mode)
 CALC_API void calculator_set_word_width(CalculatorInstance* instance, CalcWordType word_type);
 CALC_API int calculator_get_word_width(CalculatorInstance* instance);
@@ -369,9 +483,42 @@ CALC_API int calculator_history_get_count_for_mode(CalculatorInstance* instance,
 CALC_API int calculator_history_get_expression_at_for_mode(CalculatorInstance* instance, CalcMode mode, int index, char* buffer, int buffer_size);
 CALC_API int calculator_history_get_result_at_for_mode(CalculatorInstance* instance, CalcMode mode, int index, char* buffer, int buffer_size);
 
-// Set history items for current mode (used when switching back to a mode)
+// Set history items for current mode (used when switching back to a mode).
+// `json_data` is an array of {"expression": "...", "result": "..."} objects; items restored
+// this way have no expression commands, so calculator_history_load_at ignores them.
+// Malformed input leaves the history unchanged.
 CALC_API void calculator_history_set_from_vector(CalculatorInstance* instance, const char* json_data);
 
+// Binary history serialization.
+// calculator_history_save writes the history of `mode` (expressions, results, tokens and
+// expression commands) as a versioned, length-prefixed blob and returns its size in bytes.
+// Nothing is written unless buffer_size is at least that size; a NULL buffer is a size query.
+// calculator_history_restore replaces the history of `mode` without replaying any commands
+// and returns the number of items, -1 on invalid arguments or -2 on malformed data.
+// Programmer mode shares the standard history.
+CALC_API int calculator_history_save(CalculatorInstance* instance, CalcMode mode, void* buffer, int buffer_size);
+CALC_API int calculator_history_restore(CalculatorInstance* instance, CalcMode mode, const void* data, int size);
+
+// Whole-instance snapshot.
+// Captures mode, radix, word width, angle type, carry flag, history load mode, memory
+// slots, the history of every mode, the pending expression (operands, operators and open
+// parentheses) and the number being entered.
+// calculator_snapshot: on entry *len is the capacity of `buf`, on return the snapshot size.
+// Returns 0 when written, 1 when `buf` is NULL or too small (nothing is written), -1 on
+// invalid arguments.
+// calculator_restore: returns 0 on success, -1 on invalid arguments, -2 on malformed data
+// (the instance is left untouched). History is restored as stored. The pending expression
+// is rebuilt by replaying its commands; a finished equation is evaluated again, so its
+// result keeps full precision and the next digit starts a new number. A number being typed
+// is typed again and continues with the next digit. Memory slots are rebuilt at full
+// precision from the values and finished equations stored into them with the
+// calculator_memory_* functions; slots that were not tracked that way (and a value shown
+// outside any expression, e.g. recalled from memory) are re-entered from their display
+// strings and keep only display precision. An error state is restored with the same
+// message, though not the expression that caused it.
+CALC_API int calculator_snapshot(CalculatorInstance* instance, void* buf, size_t* len);
+CALC_API int calculator_restore(CalculatorInstance* instance, const void* buf, size_t len);
+
 // Clear history for a specific mode
 CALC_API void calculator_history_clear_for_mode(CalculatorInstance* instance, CalcMode mode);
 
@@ -381,6 +528,21 @@ CALC_API void calculator_history_clear_for_mode(CalculatorInstance* instance, Ca
 
 CALC_API int calculator_get_parenthesis_count(CalculatorInstance* instance);
 
+// ============================================================================
+// Expression Evaluation
+// ============================================================================
+
+// Evaluate an infix expression directly with the engine's Rational arithmetic,
+// without simulating keystrokes or updating any calculator instance.
+// Supported: decimal numbers (with optional e/E exponent), unary +/-, parentheses and
+// binary + - * / (also UTF-8 × and ÷); scientific mode also accepts "mod", "^" and "yroot".
+// Standard mode evaluates strictly left to right like the standard calculator;
+// scientific mode applies operator precedence.
+// Returns the length of the result written to `out`, -1 on invalid arguments,
+// -2 on a syntax error, -3 on a math error (e.g. division by zero) and
+// -4 if the mode is not supported.
+CALC_API int calculator_evaluate(const char* expr, CalcMode mode, char* out, int out_size);
+
 // ============================================================================
 // Unit Converter Instance Functions
 // ============================================================================
@@ -424,6 +586,23 @@ CALC_API void unit_converter_reset(UnitConverterInstance* instance);
 CALC_API int unit_converter_get_suggested_count(UnitConverterInstance* instance);
 CALC_API int unit_converter_get_suggested_value(UnitConverterInstance* instance, int index, char* value_buffer, int value_buffer_size, char* unit_buffer, int unit_buffer_size);
 
+// Direct conversion against the shared unit catalog, without an instance, keystroke
+// input or suggested values. Unit IDs are those returned by unit_converter_get_unit_id.
+// `value` is a plain decimal number ("-12.5", "1e6"); the result is formatted like the
+// converter's own "to" value (same rounding and trailing-zero trimming, scientific notation
+// past 15 integer digits or below 1e-14). The catalog is process-wide, so no handle is
+// taken. Returns the result length (see "String getters" above),
+// -1 if the units are unknown or not convertible, -2 if `value` cannot be parsed.
+CALC_API int unit_converter_convert(int from_unit_id, int to_unit_id, const char* value, char* out, int out_size);
+
+// Fast path of unit_converter_convert on doubles. Returns 1 on success, 0 otherwise.
+CALC_API int unit_converter_convert_value(int from_unit_id, int to_unit_id, double value, double* out);
+
+// Convert `count` doubles from `in` into `out` (which may alias `in`) using a vectorized
+// loop. Results are bit-identical to unit_converter_convert_value. Returns 1 on success,
+// 0 if the units are unknown or not convertible.
+CALC_API int unit_converter_convert_array(int from_unit_id, int to_unit_id, const double* in, double* out, size_t count);
+
 // ============================================================================
 // Unit Converter Commands (same as number input)
 // ============================================================================
@@ -500,6 +679,124 @@ typedef struct CalcDisplayCallbacks {
 
 CALC_API void calculator_set_all_callbacks(CalculatorInstance* instance, const CalcDisplayCallbacks* callbacks);
 
+// ============================================================================
+// Display Event Queue
+// ============================================================================
+
+// Event types, one per ICalcDisplay notification
+typedef enum {
+    CALC_EVENT_PRIMARY_DISPLAY = 1,      // value: isError, text: display string
+    CALC_EVENT_IS_IN_ERROR = 2,          // value: isInError
+    CALC_EVENT_EXPRESSION = 3,           // text: expression string
+    CALC_EVENT_PARENTHESIS = 4,          // value: parenthesis count
+    CALC_EVENT_NO_RIGHT_PAREN = 5,
+    CALC_EVENT_MAX_DIGITS = 6,
+    CALC_EVENT_BINARY_OPERATOR = 7,
+    CALC_EVENT_HISTORY_ITEM_ADDED = 8,   // value: index of the added item
+    CALC_EVENT_MEMORIZED_NUMBERS = 9,    // text: JSON array of memorized numbers
+    CALC_EVENT_MEMORY_ITEM_CHANGED = 10, // value: memory slot index
+    CALC_EVENT_INPUT_CHANGED = 11
+} CalcEventType;
+
+// Header of each drained event record. Records are packed back to back: `size` is the
+// total record size in bytes (8-byte aligned) and, for events with text, `text_length`
+// bytes of NUL-terminated UTF-8 follow the header.
+typedef struct CalcEventRecord {
+    uint32_t type;
+    uint32_t value;
+    uint32_t size;
+    uint32_t text_length;
+} CalcEventRecord;
+
+// Opt in to queued events: while enabled, display notifications are appended to a
+// per-instance single-producer/single-consumer ring buffer instead of invoking callbacks.
+// `capacity` is in bytes (rounded up to a power of two); 0 disables the queue.
+// Must not be called concurrently with calculator_drain_events. Returns 1 on success.
+CALC_API int calculator_enable_event_queue(CalculatorInstance* instance, int capacity);
+
+// Copy as many complete event records as fit into `buffer` and return the bytes written
+// (0 when the queue is empty). If the next record alone does not fit, nothing is copied
+// and the negated size of that record is returned; a NULL buffer queries it the same way.
+// May be called from a different thread than the one sending commands.
+CALC_API int calculator_drain_events(CalculatorInstance* instance, void* buffer, int buffer_size);
+
+// Number of events dropped because the queue was full since the last call
+CALC_API int calculator_get_dropped_event_count(CalculatorInstance* instance);
+
+// Coalesce display notifications per command: while enabled, state notifications
+// (primary display, error, expression, parenthesis, memorized numbers, input changed)
+// are deferred while calculator_send_command runs and delivered at most once each,
+// with the final value, when it returns. Discrete events are delivered immediately.
+CALC_API void calculator_set_callback_coalescing(CalculatorInstance* instance, int enabled);
+
+// ============================================================================
+// Instance Pool
+// ============================================================================
+
+// Pool of warm calculator instances for per-request use. Acquire hands out an idle
+// instance (a hit) or creates one (a miss). Release resets it to the state
+// calculator_create produces and keeps it for reuse. That state covers standard mode,
+// cleared memory and history, default settings, and no callbacks, user data or event queue.
+// Instances keep the locale that was current when they were created.
+// Acquire and release may be called from any thread. Release every acquired instance
+// before calculator_pool_destroy; instances that are never released must be freed with
+// calculator_destroy.
+// calculator_pool_release returns 0 when the instance was taken back, or -1 on invalid
+// arguments or when `instance` is not currently acquired from this pool (created with
+// calculator_create, acquired from another pool, or already released). A rejected
+// instance is left untouched and stays owned by the caller.
+typedef struct {
+    uint64_t hits;    // Acquires served by an idle instance
+    uint64_t misses;  // Acquires that created a new instance
+    uint64_t idle;    // Instances waiting in the pool
+    uint64_t in_use;  // Instances acquired and not yet released
+} CalcPoolStats;
+
+// Creates the pool with `initial_size` instances already built; NULL if initial_size < 0
+CALC_API CalculatorPool* calculator_pool_create(int initial_size);
+CALC_API void calculator_pool_destroy(CalculatorPool* pool);
+CALC_API CalculatorInstance* calculator_pool_acquire(CalculatorPool* pool);
+CALC_API int calculator_pool_release(CalculatorPool* pool, CalculatorInstance* instance);
+CALC_API void calculator_pool_get_stats(CalculatorPool* pool, CalcPoolStats* stats);
+
+// ============================================================================
+// Batch Evaluation
+// ============================================================================
+
+typedef enum {
+    CALC_JOB_EXPRESSION = 0,  // Evaluate `expression` like calculator_evaluate
+    CALC_JOB_COMMANDS = 1     // Send `commands` to a fresh calculator in `mode`
+} CalcJobType;
+
+typedef struct {
+    int32_t type;                       // CalcJobType
+    int32_t mode;                       // CalcMode
+    const char* expression;             // CALC_JOB_EXPRESSION: UTF-8, NUL-terminated
+    const CalculatorCommand* commands;  // CALC_JOB_COMMANDS
+    int32_t command_count;
+} CalcJob;
+
+typedef struct {
+    // 0 on success. Expression jobs: the negative calculator_evaluate error code.
+    // Command jobs: 1 if the display ended in an error state. -1 for an invalid job.
+    int32_t status;
+    int32_t length;  // Full UTF-8 length of the result; >= sizeof(text) means truncated
+    char text[64];   // Result or final primary display, NUL-terminated
+} CalcResult;
+
+// Evaluates `count` independent jobs on `threads` worker threads (<= 0 uses one per core,
+// larger values are capped at the core count) and writes out[i] for jobs[i]. The calling
+// thread is one of the workers. Workers claim jobs from their own share first, then steal
+// from the others. Returns the number of successful jobs, or -1 on invalid arguments or a
+// `count` above INT_MAX.
+// Every job takes the engine lock described under Lifecycle, so jobs still run one at a
+// time whatever the thread count. Throughput can only scale once Ratpack's global
+// constants and precision are made per-engine in CalcManager.
+// Worker threads and each worker's calculator per mode are created on first use and kept
+// for later calls; concurrent calls run one after another. Command jobs start from a
+// cleared calculator in their mode.
+CALC_API int calculator_evaluate_batch(const CalcJob* jobs, size_t count, CalcResult* out, int threads);
+
 // ============================================================================
 // Backward Compatibility (old function names)
 // ============================================================================
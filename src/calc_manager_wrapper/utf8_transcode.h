@@ -0,0 +1,209 @@
+// utf8_transcode.h
+// Wide string <-> UTF-8 transcoding for the CalcManager wrapper
+// Copyright (c) 2024. MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTF8_TRANSCODE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UTF8_TRANSCODE_NEON 1
+#endif
+
+// ============================================================================
+// ASCII fast path
+// ============================================================================
+
+// Copy the leading run of ASCII code units 16 at a time. Returns the number of code
+// units consumed (a multiple of 16); the caller finishes the rest with the scalar loop.
+// There is no AVX2 variant: display strings rarely exceed one or two 16-unit blocks.
+inline size_t utf8_copy_ascii_blocks(const wchar_t* in, size_t length, char* out) {
+    size_t i = 0;
+
+#if defined(UTF8_TRANSCODE_SSE2)
+    if constexpr (sizeof(wchar_t) == 2) {
+        const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+        for (; i + 16 <= length; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+            __m128i high = _mm_and_si128(_mm_or_si128(a, b), nonAscii);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF) break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+        }
+    } else {
+        const __m128i nonAscii = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+        for (; i + 16 <= length; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+            __m128i high = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), nonAscii);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xFFFF) break;
+            __m128i low = _mm_packs_epi32(a, b);
+            __m128i upper = _mm_packs_epi32(c, d);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, upper));
+        }
+    }
+#elif defined(UTF8_TRANSCODE_NEON)
+    if constexpr (sizeof(wchar_t) == 2) {
+        const uint16_t* units = reinterpret_cast<const uint16_t*>(in);
+        for (; i + 16 <= length; i += 16) {
+            uint16x8_t a = vld1q_u16(units + i);
+            uint16x8_t b = vld1q_u16(units + i + 8);
+            if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80) break;
+            vst1q_u8(reinterpret_cast<uint8_t*>(out + i), vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+        }
+    } else {
+        const uint32_t* units = reinterpret_cast<const uint32_t*>(in);
+        for (; i + 16 <= length; i += 16) {
+            uint32x4_t a = vld1q_u32(units + i);
+            uint32x4_t b = vld1q_u32(units + i + 4);
+            uint32x4_t c = vld1q_u32(units + i + 8);
+            uint32x4_t d = vld1q_u32(units + i + 12);
+            if (vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d))) >= 0x80) break;
+            uint16x8_t low = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+            uint16x8_t upper = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+            vst1q_u8(reinterpret_cast<uint8_t*>(out + i), vcombine_u8(vmovn_u16(low), vmovn_u16(upper)));
+        }
+    }
+#else
+    (void)in;
+    (void)length;
+    (void)out;
+#endif
+
+    return i;
+}
+
+// ============================================================================
+// Transcoder
+// ============================================================================
+
+// Upper bound on the UTF-8 size of `length` code units: 3 bytes per UTF-16 unit
+// (a surrogate pair needs 4 for 2 units) or 4 per UTF-32 unit
+constexpr size_t utf8_max_length(size_t length) {
+    return length * (sizeof(wchar_t) == 2 ? 3 : 4);
+}
+
+// Encode `length` wide code units into `out`, which must hold utf8_max_length(length)
+// bytes, and return the number of bytes written. wchar_t is UTF-16 on Windows (surrogate
+// pairs are combined) and UTF-32 elsewhere. Unpaired surrogates and values beyond
+// U+10FFFF are replaced with U+FFFD.
+inline size_t encode_utf8(const wchar_t* in, size_t length, char* out) {
+    char* const begin = out;
+    size_t i = 0;
+
+    while (i < length) {
+        size_t ascii = utf8_copy_ascii_blocks(in + i, length - i, out);
+        i += ascii;
+        out += ascii;
+
+        // Scalar loop until the next 16-unit boundary or the end of the string
+        size_t stop = std::min(length, i + 16);
+        while (i < stop) {
+            uint32_t code_point = static_cast<uint32_t>(in[i++]);
+            if (code_point <= 0x7F) {
+                *out++ = static_cast<char>(code_point);
+                continue;
+            }
+
+            if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+                uint32_t next = i < length ? static_cast<uint32_t>(in[i]) : 0;
+                if (sizeof(wchar_t) == 2 && code_point <= 0xDBFF && next >= 0xDC00 && next <= 0xDFFF) {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (next - 0xDC00);
+                    i++;
+                } else {
+                    code_point = 0xFFFD;
+                }
+            } else if (code_point > 0x10FFFF) {
+                code_point = 0xFFFD;
+            }
+
+            if (code_point <= 0x7FF) {
+                *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            } else if (code_point <= 0xFFFF) {
+                *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            } else {
+                *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+        }
+    }
+
+    return static_cast<size_t>(out - begin);
+}
+
+// Append the UTF-8 encoding of `wstr` to `result`
+inline void append_utf8(std::string& result, std::wstring_view wstr) {
+    if (wstr.empty()) return;
+
+    const size_t start = result.size();
+    result.resize(start + utf8_max_length(wstr.size()));
+    result.resize(start + encode_utf8(wstr.data(), wstr.size(), &result[start]));
+}
+
+inline std::string wstring_to_utf8(std::wstring_view wstr) {
+    // Display strings are short: encode on the stack and allocate the result once
+    char buffer[256];
+    if (utf8_max_length(wstr.size()) <= sizeof(buffer)) {
+        return std::string(buffer, encode_utf8(wstr.data(), wstr.size(), buffer));
+    }
+
+    std::string result;
+    append_utf8(result, wstr);
+    return result;
+}
+
+// Decode UTF-8 into a wide string (UTF-16 with surrogate pairs on Windows, UTF-32
+// elsewhere). Malformed sequences decode as U+FFFD.
+inline std::wstring utf8_to_wstring(std::string_view utf8) {
+    std::wstring result;
+    result.reserve(utf8.size());
+
+    size_t i = 0;
+    while (i < utf8.size()) {
+        uint32_t lead = static_cast<unsigned char>(utf8[i++]);
+        if (lead < 0x80) {
+            result.push_back(static_cast<wchar_t>(lead));
+            continue;
+        }
+
+        // 0xF5-0xFF would start sequences beyond U+10FFFF; like stray continuation
+        // bytes they are invalid on their own and consume nothing after them
+        size_t extra = lead > 0xF4 ? 0 : lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+        uint32_t code_point = lead & (0x3F >> extra);
+        size_t consumed = 0;
+        while (consumed < extra && i < utf8.size() && (static_cast<unsigned char>(utf8[i]) & 0xC0) == 0x80) {
+            code_point = (code_point << 6) | (static_cast<unsigned char>(utf8[i++]) & 0x3F);
+            consumed++;
+        }
+
+        static constexpr uint32_t minimum[] = {0, 0x80, 0x800, 0x10000};
+        if (extra == 0 || consumed != extra || code_point < minimum[extra] || code_point > 0x10FFFF ||
+            (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            code_point = 0xFFFD;
+        }
+
+        if (sizeof(wchar_t) == 2 && code_point > 0xFFFF) {
+            code_point -= 0x10000;
+            result.push_back(static_cast<wchar_t>(0xD800 + (code_point >> 10)));
+            result.push_back(static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF)));
+        } else {
+            result.push_back(static_cast<wchar_t>(code_point));
+        }
+    }
+    return result;
+}
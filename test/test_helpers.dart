@@ -2,28 +2,28 @@ import 'dart:ffi';
 import 'package:ffi/ffi.dart';
 import 'package:wincalc_engine/wincalc_engine.dart';
 
-/// Helper function to get primary display result from native buffer
-String getDisplayResult(Pointer<CalculatorInstance> instance) {
-  const bufferSize = 256;
-  final buffer = calloc<Char>(bufferSize);
+/// Helper function to read a string using the length-query protocol:
+/// one sizing call with a NULL buffer, then one fill call.
+String readString(int Function(Pointer<Char> buffer, int bufferSize) getter) {
+  final length = getter(nullptr, 0);
+  if (length < 0) return '';
+  final buffer = calloc<Char>(length + 1);
   try {
-    calculator_get_primary_display(instance, buffer, bufferSize);
-    return buffer.cast<Utf8>().toDartString();
+    getter(buffer, length + 1);
+    return buffer.cast<Utf8>().toDartString(length: length);
   } finally {
     calloc.free(buffer);
   }
 }
 
+/// Helper function to get primary display result from native buffer
+String getDisplayResult(Pointer<CalculatorInstance> instance) {
+  return readString((buffer, size) => calculator_get_primary_display(instance, buffer, size));
+}
+
 /// Helper function to get expression string
 String getExpression(Pointer<CalculatorInstance> instance) {
-  const bufferSize = 256;
-  final buffer = calloc<Char>(bufferSize);
-  try {
-    calculator_get_expression(instance, buffer, bufferSize);
-    return buffer.cast<Utf8>().toDartString();
-  } finally {
-    calloc.free(buffer);
-  }
+  return readString((buffer, size) => calculator_get_expression(instance, buffer, size));
 }
 
 /// Helper function to get result in specific radix
@@ -65,6 +65,67 @@ String getBinaryDisplay(Pointer<CalculatorInstance> instance) {
   }
 }
 
+/// Helper function to send a list of commands in a single batch
+int sendCommands(Pointer<CalculatorInstance> instance, List<int> commands) {
+  final buffer = calloc<Int32>(commands.length);
+  try {
+    for (int i = 0; i < commands.length; i++) {
+      buffer[i] = commands[i];
+    }
+    return calculator_send_commands(instance, buffer, commands.length);
+  } finally {
+    calloc.free(buffer);
+  }
+}
+
+/// Helper function to evaluate an expression string; returns null on error
+String? evaluate(String expression, CalcMode mode) {
+  const bufferSize = 256;
+  final expr = expression.toNativeUtf8();
+  final buffer = calloc<Char>(bufferSize);
+  try {
+    final length = calculator_evaluate(expr.cast<Char>(), mode, buffer, bufferSize);
+    if (length < 0) return null;
+    return buffer.cast<Utf8>().toDartString();
+  } finally {
+    calloc.free(expr);
+    calloc.free(buffer);
+  }
+}
+
+/// Helper function to drain queued display events as (type, value, text) records,
+/// growing the buffer when a record does not fit
+List<(CalcEventType, int, String?)> drainEvents(Pointer<CalculatorInstance> instance) {
+  var bufferSize = 4096;
+  var buffer = calloc<Uint8>(bufferSize);
+  try {
+    final events = <(CalcEventType, int, String?)>[];
+    while (true) {
+      final written = calculator_drain_events(instance, buffer.cast(), bufferSize);
+      if (written == 0) return events;
+      if (written < 0) {
+        calloc.free(buffer);
+        bufferSize = -written;
+        buffer = calloc<Uint8>(bufferSize);
+        continue;
+      }
+
+      var offset = 0;
+      while (offset < written) {
+        final record = (buffer + offset).cast<CalcEventRecord>().ref;
+        final hasText = record.size > sizeOf<CalcEventRecord>() + record.text_length;
+        final text = hasText
+            ? (buffer + offset + sizeOf<CalcEventRecord>()).cast<Utf8>().toDartString(length: record.text_length)
+            : null;
+        events.add((CalcEventType.fromValue(record.type), record.value, text));
+        offset += record.size;
+      }
+    }
+  } finally {
+    calloc.free(buffer);
+  }
+}
+
 /// Helper function to send a digit command (0-9)
 void sendDigit(Pointer<CalculatorInstance> instance, int digit) {
   final command = switch (digit) {
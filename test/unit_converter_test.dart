@@ -0,0 +1,163 @@
+import 'dart:ffi';
+import 'package:ffi/ffi.dart';
+import 'package:test/test.dart';
+import 'package:wincalc_engine/wincalc_engine.dart';
+
+// Unit IDs from the unit converter catalog
+const int UNIT_METERS = 100;
+const int UNIT_KILOMETERS = 101;
+const int UNIT_FEET = 108;
+const int UNIT_CELSIUS = 300;
+const int UNIT_FAHRENHEIT = 301;
+const int UNIT_KELVIN = 302;
+const int UNIT_KILOPASCALS = 1001;
+const int UNIT_PSI = 1004;
+
+/// Helper function to convert a decimal string; returns null on error
+String? convert(int from, int to, String value) {
+  const bufferSize = 64;
+  final input = value.toNativeUtf8();
+  final buffer = calloc<Char>(bufferSize);
+  try {
+    final length = unit_converter_convert(from, to, input.cast<Char>(), buffer, bufferSize);
+    if (length < 0) return null;
+    return buffer.cast<Utf8>().toDartString();
+  } finally {
+    calloc.free(input);
+    calloc.free(buffer);
+  }
+}
+
+/// Helper function to convert a double; returns null on error
+double? convertValue(int from, int to, double value) {
+  final out = calloc<Double>();
+  try {
+    if (unit_converter_convert_value(from, to, value, out) == 0) return null;
+    return out.value;
+  } finally {
+    calloc.free(out);
+  }
+}
+
+/// Helper function to convert by typing `value` into a converter instance and reading
+/// the "to" display, which is what unit_converter_convert is expected to reproduce
+String typeAndConvert(int category, int from, int to, String value) {
+  const bufferSize = 64;
+  final converter = unit_converter_create();
+  final buffer = calloc<Char>(bufferSize);
+  try {
+    unit_converter_set_category(converter, category);
+    unit_converter_set_from_unit(converter, from);
+    unit_converter_set_to_unit(converter, to);
+    unit_converter_send_command(converter, UNIT_CMD_CLEAR);
+
+    for (final char in value.replaceFirst('-', '').split('')) {
+      unit_converter_send_command(
+        converter,
+        char == '.' ? UNIT_CMD_DECIMAL : UNIT_CMD_0 + int.parse(char),
+      );
+    }
+    if (value.startsWith('-')) {
+      unit_converter_send_command(converter, UNIT_CMD_NEGATE);
+    }
+
+    unit_converter_get_to_value(converter, buffer, bufferSize);
+    return buffer.cast<Utf8>().toDartString();
+  } finally {
+    calloc.free(buffer);
+    unit_converter_destroy(converter);
+  }
+}
+
+void main() {
+  group('Direct Conversion', () {
+    test('scale conversions', () {
+      expect(convert(UNIT_KILOMETERS, UNIT_METERS, '1.5'), '1500');
+      expect(convert(UNIT_FEET, UNIT_METERS, '10'), '3.048');
+      expect(convert(UNIT_METERS, UNIT_METERS, '42'), '42');
+    });
+
+    test('offset conversions', () {
+      expect(convert(UNIT_CELSIUS, UNIT_FAHRENHEIT, '100'), '212');
+      expect(convert(UNIT_KELVIN, UNIT_CELSIUS, '0'), '-273.15');
+      expect(convert(UNIT_CELSIUS, UNIT_KELVIN, '-273.15'), '0');
+    });
+
+    test('double fast path matches string path', () {
+      final value = convertValue(UNIT_PSI, UNIT_KILOPASCALS, 30.0)!;
+      expect(value, closeTo(206.84271, 1e-9));
+      expect(double.parse(convert(UNIT_PSI, UNIT_KILOPASCALS, '30')!), closeTo(value, 1e-9));
+    });
+
+    test('formatting matches the keystroke path', () {
+      const lengthCategory = 0;
+      const temperatureCategory = 2;
+      const lengths = ['1', '0.1', '12345.6789', '123456789012', '0.000123456789', '3.14159265358979'];
+      const temperatures = ['-40', '36.6', '98.76543210123', '0.001'];
+
+      for (final value in lengths) {
+        for (final (from, to) in [(UNIT_METERS, UNIT_FEET), (UNIT_FEET, UNIT_KILOMETERS)]) {
+          expect(convert(from, to, value), typeAndConvert(lengthCategory, from, to, value),
+              reason: '$value from $from to $to');
+        }
+      }
+      for (final value in temperatures) {
+        expect(convert(UNIT_CELSIUS, UNIT_FAHRENHEIT, value),
+            typeAndConvert(temperatureCategory, UNIT_CELSIUS, UNIT_FAHRENHEIT, value),
+            reason: value);
+      }
+    });
+
+    test('units from different categories are rejected', () {
+      expect(convert(UNIT_METERS, UNIT_CELSIUS, '1'), isNull);
+      expect(convertValue(UNIT_METERS, UNIT_CELSIUS, 1), isNull);
+    });
+
+    test('malformed values are rejected', () {
+      expect(convert(UNIT_METERS, UNIT_FEET, ''), isNull);
+      expect(convert(UNIT_METERS, UNIT_FEET, '1.2.3'), isNull);
+      expect(convert(UNIT_METERS, UNIT_FEET, 'abc'), isNull);
+    });
+  });
+
+  group('Array Conversion', () {
+    test('matches single-value conversion for every element', () {
+      const count = 37; // Not a multiple of the vector width, to exercise the tail
+      final input = calloc<Double>(count);
+      final output = calloc<Double>(count);
+      try {
+        for (int i = 0; i < count; i++) {
+          input[i] = i * 1.25 - 10;
+        }
+
+        for (final (from, to) in [(UNIT_PSI, UNIT_KILOPASCALS), (UNIT_FAHRENHEIT, UNIT_KELVIN)]) {
+          expect(unit_converter_convert_array(from, to, input, output, count), 1);
+          for (int i = 0; i < count; i++) {
+            expect(output[i], convertValue(from, to, input[i]));
+          }
+        }
+      } finally {
+        calloc.free(input);
+        calloc.free(output);
+      }
+    });
+
+    test('converts in place', () {
+      final values = calloc<Double>(3);
+      try {
+        values[0] = 0;
+        values[1] = 100;
+        values[2] = -40;
+
+        expect(unit_converter_convert_array(UNIT_CELSIUS, UNIT_FAHRENHEIT, values, values, 3), 1);
+        expect([values[0], values[1], values[2]], [32, 212, -40]);
+      } finally {
+        calloc.free(values);
+      }
+    });
+
+    test('unknown units are rejected', () {
+      expect(unit_converter_convert_array(UNIT_METERS, UNIT_CELSIUS, nullptr, nullptr, 0), 0);
+    });
+  });
+}
@@ -0,0 +1,269 @@
+import 'dart:ffi';
+import 'dart:isolate';
+import 'package:ffi/ffi.dart';
+import 'package:test/test.dart';
+import 'package:wincalc_engine/wincalc_engine.dart';
+import 'test_helpers.dart';
+
+/// Runs `rounds` calculations on a private instance in the given mode and returns the
+/// displays that differ from the expected values (empty on success)
+List<String> _drive(CalcMode mode, int rounds) {
+  final calc = calculator_create();
+  final failures = <String>[];
+  try {
+    switch (mode) {
+      case CalcMode.CALC_MODE_STANDARD:
+        calculator_set_standard_mode(calc);
+      case CalcMode.CALC_MODE_SCIENTIFIC:
+        calculator_set_scientific_mode(calc);
+      case CalcMode.CALC_MODE_PROGRAMMER:
+        calculator_set_programmer_mode(calc);
+        calculator_set_radix(calc, CalcRadixType.CALC_RADIX_HEX);
+    }
+
+    for (var i = 0; i < rounds; i++) {
+      calculator_send_command(calc, CMD_CLEAR);
+      final (commands, expected) = switch (mode) {
+        CalcMode.CALC_MODE_STANDARD => ([CMD_1, CMD_DIVIDE, CMD_8, CMD_EQUALS], '0.125'),
+        CalcMode.CALC_MODE_SCIENTIFIC => ([CMD_OPENP, CMD_2, CMD_ADD, CMD_3, CMD_CLOSEP, CMD_MULTIPLY, CMD_7, CMD_EQUALS], '35'),
+        CalcMode.CALC_MODE_PROGRAMMER => ([CMD_F, CMD_F, CMD_ADD, CMD_1, CMD_EQUALS], '100'),
+      };
+      sendCommands(calc, commands);
+      final display = getDisplayResult(calc);
+      if (display != expected) failures.add('$mode round $i: $display');
+    }
+  } finally {
+    calculator_destroy(calc);
+  }
+  return failures;
+}
+
+/// Moves the history of a private instance into another one `rounds` times and returns
+/// the rounds whose copy has the wrong length (empty on success)
+List<String> _copyHistory(int rounds) {
+  final source = calculator_create();
+  final target = calculator_create();
+  const mode = CalcMode.CALC_MODE_STANDARD;
+  final failures = <String>[];
+  try {
+    for (var i = 0; i < rounds; i++) {
+      sendCommands(source, [CMD_1, CMD_DIVIDE, CMD_8, CMD_EQUALS]);
+      final size = calculator_history_save(source, mode, nullptr, 0);
+      final buffer = calloc<Uint8>(size);
+      try {
+        calculator_history_save(source, mode, buffer.cast(), size);
+        final restored = calculator_history_restore(target, mode, buffer.cast(), size);
+        if (restored != calculator_history_get_count(source)) failures.add('history round $i: $restored');
+      } finally {
+        calloc.free(buffer);
+      }
+      if (i % 10 == 9) calculator_history_clear(source);
+    }
+  } finally {
+    calculator_destroy(source);
+    calculator_destroy(target);
+  }
+  return failures;
+}
+
+void main() {
+  group('Concurrent Instances', () {
+    test('isolates in mixed modes compute independently', () async {
+      const isolates = 8;
+      const rounds = 200;
+      final runs = [
+        for (var i = 0; i < isolates; i++)
+          Isolate.run(() => _drive(CalcMode.values[i % CalcMode.values.length], rounds)),
+      ];
+
+      final failures = (await Future.wait(runs)).expand((f) => f).toList();
+      expect(failures, isEmpty);
+    });
+
+    test('expression evaluation is safe alongside engine instances', () async {
+      final runs = [
+        Isolate.run(() => _drive(CalcMode.CALC_MODE_PROGRAMMER, 200)),
+        for (var i = 0; i < 4; i++)
+          Isolate.run(() => [
+                for (var n = 0; n < 200; n++)
+                  if (evaluate('1 / 8 + 2 * 3', CalcMode.CALC_MODE_SCIENTIFIC) != '6.125') 'evaluate round $n',
+              ]),
+      ];
+
+      final failures = (await Future.wait(runs)).expand((f) => f).toList();
+      expect(failures, isEmpty);
+    });
+
+    test('history exports are safe alongside engine instances', () async {
+      final runs = [
+        for (var i = 0; i < 2; i++) Isolate.run(() => _drive(CalcMode.CALC_MODE_SCIENTIFIC, 200)),
+        for (var i = 0; i < 4; i++) Isolate.run(() => _copyHistory(100)),
+      ];
+
+      final failures = (await Future.wait(runs)).expand((f) => f).toList();
+      expect(failures, isEmpty);
+    });
+  });
+
+  group('Callback Delivery', () {
+    test('callbacks run after the command and may call back in', () {
+      final calc = calculator_create();
+      final displays = <String>[];
+      late final NativeCallable<CalcDisplaySetPrimaryDisplayCallbackFunction> onDisplay;
+      onDisplay = NativeCallable<CalcDisplaySetPrimaryDisplayCallbackFunction>.isolateLocal(
+          (Pointer<Char> text, int isError, Pointer<Void> userData) {
+        final display = text.cast<Utf8>().toDartString();
+        displays.add(display);
+        // Runs once the engine has finished the '=', so this does not re-enter it mid-command
+        if (display == '5') calculator_send_command(calc, CMD_CLEAR);
+      });
+      try {
+        calculator_set_primary_display_callback(calc, onDisplay.nativeFunction);
+        sendCommands(calc, [CMD_2, CMD_ADD, CMD_3, CMD_EQUALS]);
+
+        // The clear sent from the callback is reported after the '=' that triggered it
+        expect(displays.last, '0');
+        expect(displays[displays.length - 2], '5');
+        expect(getDisplayResult(calc), '0');
+      } finally {
+        calculator_destroy(calc);
+        onDisplay.close();
+      }
+    });
+  });
+
+  group('Batch Evaluation', () {
+    String text(CalcResult result) {
+      final bytes = <int>[];
+      for (int i = 0; result.text[i] != 0; i++) {
+        bytes.add(result.text[i]);
+      }
+      return String.fromCharCodes(bytes);
+    }
+
+    test('results line up with jobs across threads', () {
+      const count = 64;
+      final programs = [
+        ([CMD_1, CMD_DIVIDE, CMD_8, CMD_EQUALS], '0.125'),
+        ([CMD_9, CMD_SQRT], '3'),
+      ];
+      final jobs = calloc<CalcJob>(count);
+      final results = calloc<CalcResult>(count);
+      final allocations = <Pointer>[];
+      try {
+        for (var i = 0; i < count; i++) {
+          final job = (jobs + i).ref;
+          if (i.isEven) {
+            final expression = '$i * 2 + 1'.toNativeUtf8();
+            allocations.add(expression);
+            job
+              ..type = CalcJobType.CALC_JOB_EXPRESSION.value
+              ..mode = CalcMode.CALC_MODE_SCIENTIFIC.value
+              ..expression = expression.cast();
+          } else {
+            final (program, _) = programs[(i ~/ 2) % programs.length];
+            final commands = calloc<Int32>(program.length);
+            allocations.add(commands);
+            for (var c = 0; c < program.length; c++) {
+              commands[c] = program[c];
+            }
+            job
+              ..type = CalcJobType.CALC_JOB_COMMANDS.value
+              ..mode = CalcMode.CALC_MODE_STANDARD.value
+              ..commands = commands
+              ..command_count = program.length;
+          }
+        }
+
+        expect(calculator_evaluate_batch(jobs, count, results, 4), count);
+        for (var i = 0; i < count; i++) {
+          final result = (results + i).ref;
+          final expected = i.isEven ? '${i * 2 + 1}' : programs[(i ~/ 2) % programs.length].$2;
+          expect(result.status, 0, reason: 'job $i');
+          expect(text(result), expected, reason: 'job $i');
+          expect(result.length, expected.length);
+        }
+      } finally {
+        allocations.forEach(calloc.free);
+        calloc.free(jobs);
+        calloc.free(results);
+      }
+    });
+
+    test('command jobs start clean across calls', () {
+      /// Runs each program as a scientific command job in its own single-job batch
+      List<String> runEach(List<List<int>> programs) => [
+            for (final program in programs)
+              using((arena) {
+                final commands = arena<Int32>(program.length);
+                for (var c = 0; c < program.length; c++) {
+                  commands[c] = program[c];
+                }
+                final job = arena<CalcJob>()
+                  ..ref.type = CalcJobType.CALC_JOB_COMMANDS.value
+                  ..ref.mode = CalcMode.CALC_MODE_SCIENTIFIC.value
+                  ..ref.commands = commands
+                  ..ref.command_count = program.length;
+                final result = arena<CalcResult>();
+                calculator_evaluate_batch(job, 1, result, 1);
+                return text(result.ref);
+              }),
+          ];
+
+      expect(
+          runEach([
+            [CMD_5, CMD_ADD],
+            [CMD_3, CMD_EQUALS],
+            [CMD_7, CMD_MS],
+            [CMD_MR],
+            [CMD_RAD],
+            [CMD_9, CMD_0, CMD_SIN],
+          ]),
+          ['5', '3', '7', '0', '0', '1']);
+    });
+
+    test('reports failing jobs without stopping the batch', () {
+      final jobs = calloc<CalcJob>(3);
+      final results = calloc<CalcResult>(3);
+      final good = '2 + 2'.toNativeUtf8();
+      final bad = '2 +'.toNativeUtf8();
+      final divide = calloc<Int32>(4)
+        ..[0] = CMD_1
+        ..[1] = CMD_DIVIDE
+        ..[2] = CMD_0
+        ..[3] = CMD_EQUALS;
+      try {
+        jobs[0]
+          ..type = CalcJobType.CALC_JOB_EXPRESSION.value
+          ..mode = CalcMode.CALC_MODE_SCIENTIFIC.value
+          ..expression = good.cast();
+        jobs[1]
+          ..type = CalcJobType.CALC_JOB_EXPRESSION.value
+          ..mode = CalcMode.CALC_MODE_SCIENTIFIC.value
+          ..expression = bad.cast();
+        jobs[2]
+          ..type = CalcJobType.CALC_JOB_COMMANDS.value
+          ..mode = CalcMode.CALC_MODE_STANDARD.value
+          ..commands = divide
+          ..command_count = 4;
+
+        expect(calculator_evaluate_batch(jobs, 3, results, 0), 1);
+        expect(results[0].status, 0);
+        expect(results[1].status, lessThan(0));
+        expect(results[2].status, 1);
+        expect(calculator_evaluate_batch(nullptr, 3, results, 1), -1);
+        expect(calculator_evaluate_batch(nullptr, 0, nullptr, 1), 0);
+        // The success count could not be returned, so nothing runs
+        expect(calculator_evaluate_batch(jobs, 0x80000000, results, 1), -1);
+        // Thread counts beyond the core count are capped, not rejected
+        expect(calculator_evaluate_batch(jobs, 3, results, 1 << 20), 1);
+      } finally {
+        calloc.free(jobs);
+        calloc.free(results);
+        calloc.free(good);
+        calloc.free(bad);
+        calloc.free(divide);
+      }
+    });
+  });
+}
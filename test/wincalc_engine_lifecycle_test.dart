@@ -1,6 +1,8 @@
 import 'dart:ffi';
+import 'package:ffi/ffi.dart';
 import 'package:test/test.dart';
 import 'package:wincalc_engine/wincalc_engine.dart';
+import 'test_helpers.dart';
 
 void main() {
   group('Calculator Lifecycle', () {
@@ -211,4 +213,80 @@ void main() {
       }
     });
   });
+
+  group('Instance Pool', () {
+    late Pointer<CalculatorPool> pool;
+    late Pointer<CalcPoolStats> stats;
+
+    setUp(() {
+      pool = calculator_pool_create(2);
+      stats = calloc<CalcPoolStats>();
+    });
+
+    tearDown(() {
+      calculator_pool_destroy(pool);
+      calloc.free(stats);
+    });
+
+    test('prewarmed instances are hits, extra acquires are misses', () {
+      final a = calculator_pool_acquire(pool);
+      final b = calculator_pool_acquire(pool);
+      final c = calculator_pool_acquire(pool);
+
+      calculator_pool_get_stats(pool, stats);
+      expect(stats.ref.hits, 2);
+      expect(stats.ref.misses, 1);
+      expect(stats.ref.idle, 0);
+      expect(stats.ref.in_use, 3);
+
+      for (final instance in [a, b, c]) {
+        calculator_pool_release(pool, instance);
+      }
+      calculator_pool_get_stats(pool, stats);
+      expect(stats.ref.idle, 3);
+      expect(stats.ref.in_use, 0);
+    });
+
+    test('released instances come back in a clean state', () {
+      final instance = calculator_pool_acquire(pool);
+      calculator_set_programmer_mode(instance);
+      calculator_set_word_width(instance, CalcWordType.CALC_WORD_BYTE);
+      calculator_set_radix(instance, CalcRadixType.CALC_RADIX_HEX);
+      sendCommands(instance, [CMD_A, CMD_ADD, CMD_1, CMD_EQUALS]);
+      calculator_memory_store(instance);
+      calculator_set_carry_flag(instance, 1);
+      calculator_pool_release(pool, instance);
+
+      // The pool is LIFO, so the same instance is handed out again
+      final reused = calculator_pool_acquire(pool);
+      expect(reused, instance);
+      expect(calculator_get_current_mode(reused), CalcMode.CALC_MODE_STANDARD.value);
+      expect(calculator_get_radix(reused), CalcRadixType.CALC_RADIX_DECIMAL.value);
+      expect(calculator_get_carry_flag(reused), 0);
+      expect(calculator_memory_get_count(reused), 0);
+      expect(calculator_history_get_count(reused), 0);
+      expect(getDisplayResult(reused), '0');
+
+      calculator_set_programmer_mode(reused);
+      expect(calculator_get_word_width(reused), CalcWordType.CALC_WORD_QWORD.value);
+      calculator_pool_release(pool, reused);
+    });
+
+    test('release rejects instances the pool did not hand out', () {
+      final foreign = calculator_create();
+      try {
+        expect(calculator_pool_release(pool, foreign), -1);
+      } finally {
+        calculator_destroy(foreign);
+      }
+
+      final instance = calculator_pool_acquire(pool);
+      expect(calculator_pool_release(pool, instance), 0);
+      expect(calculator_pool_release(pool, instance), -1);
+
+      calculator_pool_get_stats(pool, stats);
+      expect(stats.ref.idle, 2);
+      expect(stats.ref.in_use, 0);
+    });
+  });
 }
@@ -1,4 +1,5 @@
 import 'dart:ffi';
+import 'package:ffi/ffi.dart';
 import 'package:test/test.dart';
 import 'package:wincalc_engine/wincalc_engine.dart';
 import 'test_helpers.dart';
@@ -340,6 +341,151 @@ void main() {
     });
   });
 
+  group('All-Radix Snapshot', () {
+    String field(Array<Char> chars) {
+      final bytes = <int>[];
+      for (int i = 0; chars[i] != 0; i++) {
+        bytes.add(chars[i]);
+      }
+      return String.fromCharCodes(bytes);
+    }
+
+    test('matches the individual radix getters', () {
+      sendNumber(calc, 1234567);
+
+      final snapshot = calloc<CalcRadixSnapshot>();
+      try {
+        expect(calculator_get_all_radix_results(calc, snapshot), 1);
+        expect(snapshot.ref.value, 1234567);
+        expect(field(snapshot.ref.hex), getResultInRadix(calc, 16));
+        expect(field(snapshot.ref.dec), getResultInRadix(calc, 10));
+        expect(field(snapshot.ref.oct), getResultInRadix(calc, 8));
+        expect(field(snapshot.ref.bin), getResultInRadix(calc, 2));
+        expect(field(snapshot.ref.bits), getBinaryDisplay(calc));
+      } finally {
+        calloc.free(snapshot);
+      }
+    });
+
+    test('negative values use the word width', () {
+      calculator_set_word_width(calc, CalcWordType.CALC_WORD_BYTE);
+      sendNumber(calc, 1);
+      calculator_send_command(calc, CMD_NEGATE);
+
+      final snapshot = calloc<CalcRadixSnapshot>();
+      try {
+        expect(calculator_get_all_radix_results(calc, snapshot), 1);
+        expect(snapshot.ref.value, 0xFF);
+        expect(field(snapshot.ref.hex), getResultInRadix(calc, 16));
+        expect(field(snapshot.ref.dec), getResultInRadix(calc, 10));
+        expect(field(snapshot.ref.bin), getResultInRadix(calc, 2));
+      } finally {
+        calloc.free(snapshot);
+      }
+    });
+
+    test('decimal follows the locale grouping pattern', () {
+      final locale = calloc<CalcLocale>();
+      final grouping = '3;2;0'.toNativeUtf8();
+      locale.ref.grouping = grouping.cast();
+      calculator_set_locale(locale);
+      final localized = calculator_create();
+      final snapshot = calloc<CalcRadixSnapshot>();
+      try {
+        calculator_set_programmer_mode(localized);
+        sendNumber(localized, 1234567);
+
+        expect(calculator_get_all_radix_results(localized, snapshot), 1);
+        expect(field(snapshot.ref.dec), '12,34,567');
+        expect(field(snapshot.ref.dec), getResultInRadix(localized, 10));
+      } finally {
+        calculator_destroy(localized);
+        calculator_set_locale(nullptr);
+        calloc.free(snapshot);
+        calloc.free(grouping);
+        calloc.free(locale);
+      }
+    });
+  });
+
+  group('Packed Bit Access', () {
+    (int, int)? valueBits() {
+      final bits = calloc<Uint64>();
+      final width = calloc<Int>();
+      try {
+        if (calculator_get_value_bits(calc, bits, width) == 0) return null;
+        return (bits.value, width.value);
+      } finally {
+        calloc.free(bits);
+        calloc.free(width);
+      }
+    }
+
+    test('returns raw bits and word width', () {
+      sendNumber(calc, 255);
+      expect(valueBits(), (255, 64));
+
+      calculator_set_word_width(calc, CalcWordType.CALC_WORD_BYTE);
+      calculator_send_command(calc, CMD_CLEAR);
+      sendNumber(calc, 1);
+      calculator_send_command(calc, CMD_NEGATE);
+      expect(valueBits(), (0xFF, 8));
+    });
+
+    test('toggle_bits matches individual BINPOS commands', () {
+      expect(calculator_toggle_bits(calc, 0x8000000000000005), 1);
+      final (bits, _) = valueBits()!;
+
+      calculator_send_command(calc, CMD_CLEAR);
+      for (final n in [0, 2, 63]) {
+        calculator_send_command(calc, CMD_BINPOS(n));
+      }
+
+      expect(bits, valueBits()!.$1);
+      expect(bits, 0x8000000000000005);
+    });
+
+    test('toggle_bits keeps untouched bits in every radix', () {
+      for (final radix in CalcRadixType.values) {
+        calculator_set_radix(calc, radix);
+        calculator_send_command(calc, CMD_CLEAR);
+        calculator_toggle_bits(calc, 0xF0);
+        calculator_toggle_bits(calc, 0x0F | 0x80);
+        expect(valueBits(), (0x7F, 64), reason: '$radix');
+      }
+    });
+
+    test('toggle_bits sets the sign bit at narrow widths', () {
+      calculator_set_word_width(calc, CalcWordType.CALC_WORD_BYTE);
+      calculator_toggle_bits(calc, 0x80);
+      expect(valueBits(), (0x80, 8));
+      expect(getResultInRadix(calc, 10), '-128');
+    });
+
+    test('toggle_bits reports one display update', () {
+      calculator_enable_event_queue(calc, 4096);
+      sendNumber(calc, 5);
+      drainEvents(calc);
+
+      calculator_toggle_bits(calc, 0xFF00);
+      final displays = drainEvents(calc).where((e) => e.$1 == CalcEventType.CALC_EVENT_PRIMARY_DISPLAY);
+      expect(displays.length, 1);
+      expect(valueBits(), (0xFF05, 64));
+    });
+
+    test('bits beyond the word width are ignored', () {
+      calculator_set_word_width(calc, CalcWordType.CALC_WORD_BYTE);
+      calculator_toggle_bits(calc, 0x1FF);
+      expect(valueBits(), (0xFF, 8));
+    });
+
+    test('not available outside programmer mode', () {
+      calculator_set_standard_mode(calc);
+      expect(calculator_get_value_bits(calc, nullptr, nullptr), 0);
+      expect(calculator_toggle_bits(calc, 1), 0);
+    });
+  });
+
   group('Word Width Impact on Calculations', () {
     test('BYTE mode limits max value to 255', () {
       calculator_set_word_width(calc, CalcWordType.CALC_WORD_BYTE);
@@ -1,4 +1,5 @@
 import 'dart:ffi';
+import 'package:ffi/ffi.dart';
 import 'package:test/test.dart';
 import 'package:wincalc_engine/wincalc_engine.dart';
 import 'test_helpers.dart';
@@ -565,6 +566,631 @@ void main() {
     });
   });
 
+  group('Batched Commands', () {
+    test('5 + 3 = 8 in one batch', () {
+      final result = sendCommands(calc, [CMD_5, CMD_ADD, CMD_3, CMD_EQUALS]);
+
+      expect(result, 4);
+      expect(getDisplayResult(calc), '8');
+    });
+
+    test('batch matches individual commands', () {
+      sendCommands(calc, [CMD_1, CMD_2, CMD_MULTIPLY, CMD_3, CMD_EQUALS]);
+      final batched = getDisplayResult(calc);
+
+      calculator_send_command(calc, CMD_CLEAR);
+      sendNumber(calc, 12);
+      calculator_send_command(calc, CMD_MULTIPLY);
+      sendNumber(calc, 3);
+      calculator_send_command(calc, CMD_EQUALS);
+
+      expect(batched, getDisplayResult(calc));
+    });
+
+    test('returns index of first command that produced an error', () {
+      final result = sendCommands(calc, [CMD_5, CMD_DIVIDE, CMD_0, CMD_EQUALS, CMD_1]);
+
+      expect(result, 3);
+      expect(calculator_has_error(calc) != 0, isTrue);
+    });
+
+    test('empty batch is accepted', () {
+      expect(sendCommands(calc, []), 0);
+    });
+
+    test('an error from before the batch is not attributed to it', () {
+      sendCommands(calc, [CMD_5, CMD_DIVIDE, CMD_0, CMD_EQUALS]);
+      expect(calculator_has_error(calc) != 0, isTrue);
+
+      expect(sendCommands(calc, [CMD_CLEAR, CMD_1, CMD_ADD, CMD_2]), 4);
+      expect(sendCommands(calc, [CMD_CLEAR, CMD_1, CMD_DIVIDE, CMD_0, CMD_EQUALS]), 4);
+    });
+
+    test('discrete events are delivered after the batch', () {
+      calculator_enable_event_queue(calc, 4096);
+      sendCommands(calc, [CMD_1, CMD_ADD, CMD_2, CMD_EQUALS]);
+
+      final types = drainEvents(calc).map((e) => e.$1).toList();
+      expect(types, contains(CalcEventType.CALC_EVENT_HISTORY_ITEM_ADDED));
+      expect(types.indexOf(CalcEventType.CALC_EVENT_HISTORY_ITEM_ADDED),
+          lessThan(types.indexOf(CalcEventType.CALC_EVENT_PRIMARY_DISPLAY)));
+    });
+  });
+
+  group('Length Query Protocol', () {
+    test('NULL buffer returns required length', () {
+      sendNumber(calc, 123);
+      expect(calculator_get_primary_display(calc, nullptr, 0), 3);
+    });
+
+    test('truncated copy reports full length', () {
+      sendNumber(calc, 123);
+
+      final buffer = calloc<Char>(3);
+      try {
+        final length = calculator_get_primary_display(calc, buffer, 3);
+        expect(length, 3);
+        expect(buffer.cast<Utf8>().toDartString(), '12');
+      } finally {
+        calloc.free(buffer);
+      }
+    });
+  });
+
+  group('Zero-Copy Display Access', () {
+    test('peek primary display matches copied display', () {
+      sendNumber(calc, 42);
+
+      final len = calloc<Int>();
+      try {
+        final text = calculator_peek_primary_display(calc, len);
+        expect(text.cast<Utf8>().toDartString(length: len.value), getDisplayResult(calc));
+        expect(len.value, 2);
+      } finally {
+        calloc.free(len);
+      }
+    });
+
+    test('peek expression matches copied expression', () {
+      sendNumber(calc, 7);
+      calculator_send_command(calc, CMD_ADD);
+
+      final text = calculator_peek_expression(calc, nullptr);
+      expect(text.cast<Utf8>().toDartString(), getExpression(calc));
+    });
+  });
+
+  group('Incremental Expression', () {
+    String tokenAt(int index) =>
+        readString((buffer, size) => calculator_get_expression_token(calc, index, buffer, size));
+
+    List<String> allTokens() =>
+        [for (var i = 0; i < calculator_get_expression_token_count(calc); i++) tokenAt(i)];
+
+    /// Applies the pending diff to `rendered` and returns whether anything changed
+    bool applyDiff(List<String> rendered) {
+      final diff = calloc<CalcExpressionDiff>();
+      try {
+        final changed = calculator_get_expression_diff(calc, diff);
+        final d = diff.ref;
+        rendered.replaceRange(d.index, d.index + d.removed_count,
+            [for (var i = d.index; i < d.index + d.inserted_count; i++) tokenAt(i)]);
+        expect(rendered.length, d.token_count);
+        return changed == 1;
+      } finally {
+        calloc.free(diff);
+      }
+    }
+
+    test('tokens join to the expression string', () {
+      calculator_set_scientific_mode(calc);
+      sendCommands(calc, [CMD_OPENP, CMD_1, CMD_ADD, CMD_2, CMD_CLOSEP, CMD_MULTIPLY]);
+
+      expect(allTokens(), isNotEmpty);
+      expect(allTokens().map((t) => '$t ').join(), getExpression(calc));
+    });
+
+    test('patching with each diff reproduces the token list', () {
+      calculator_set_scientific_mode(calc);
+      final rendered = <String>[];
+      final commands = [
+        CMD_OPENP, CMD_1, CMD_ADD, CMD_2, CMD_CLOSEP, CMD_MULTIPLY,
+        CMD_3, CMD_SUBTRACT, CMD_SQRT, CMD_DIVIDE, CMD_4, CMD_EQUALS, CMD_ADD, CMD_CLEAR,
+      ];
+      for (final command in commands) {
+        calculator_send_command(calc, command);
+        applyDiff(rendered);
+        expect(rendered, allTokens());
+      }
+    });
+
+    test('diff accumulates across commands until read', () {
+      calculator_set_scientific_mode(calc);
+      final rendered = <String>[];
+      applyDiff(rendered);
+
+      sendCommands(calc, [CMD_1, CMD_ADD, CMD_2, CMD_MULTIPLY, CMD_OPENP]);
+      expect(applyDiff(rendered), isTrue);
+      expect(rendered, allTokens());
+
+      expect(applyDiff(rendered), isFalse);
+      expect(rendered, allTokens());
+    });
+
+    test('structured tokens carry type, command and text', () {
+      calculator_set_scientific_mode(calc);
+      sendCommands(calc, [CMD_OPENP, CMD_1, CMD_ADD, CMD_2, CMD_CLOSEP, CMD_MULTIPLY]);
+
+      final count = calculator_get_expression_tokens(calc, nullptr, 0);
+      final tokens = calloc<CalcToken>(count);
+      try {
+        expect(calculator_get_expression_tokens(calc, tokens, count), count);
+
+        final texts = [
+          for (var i = 0; i < count; i++) tokens[i].text.cast<Utf8>().toDartString(length: tokens[i].length)
+        ];
+        expect(texts, allTokens());
+
+        final kinds = [for (var i = 0; i < count; i++) CalcTokenType.fromValue(tokens[i].type)];
+        expect(kinds.first, CalcTokenType.CALC_TOKEN_PARENTHESIS);
+        expect(tokens[0].command, CMD_OPENP);
+        expect(kinds, contains(CalcTokenType.CALC_TOKEN_OPERAND));
+
+        final add = kinds.indexOf(CalcTokenType.CALC_TOKEN_BINARY);
+        expect(tokens[add].command, CMD_ADD);
+        expect(kinds.last, CalcTokenType.CALC_TOKEN_BINARY);
+        expect(tokens[count - 1].command, CMD_MULTIPLY);
+      } finally {
+        calloc.free(tokens);
+      }
+    });
+
+    test('out of range token index returns -1', () {
+      expect(calculator_get_expression_token(calc, 0, nullptr, 0), -1);
+      expect(calculator_get_expression_token(calc, -1, nullptr, 0), -1);
+    });
+  });
+
+  group('Expression Evaluation', () {
+    test('5 + 3 = 8', () {
+      expect(evaluate('5 + 3', CalcMode.CALC_MODE_STANDARD), '8');
+    });
+
+    test('standard mode evaluates left to right', () {
+      expect(evaluate('2 + 3 * 4', CalcMode.CALC_MODE_STANDARD), '20');
+    });
+
+    test('scientific mode applies precedence', () {
+      expect(evaluate('2 + 3 * 4', CalcMode.CALC_MODE_SCIENTIFIC), '14');
+      expect(evaluate('(2 + 3) * 4', CalcMode.CALC_MODE_SCIENTIFIC), '20');
+      expect(evaluate('2 ^ 10', CalcMode.CALC_MODE_SCIENTIFIC), '1024');
+    });
+
+    test('decimals and negation', () {
+      expect(evaluate('1.5 * -2', CalcMode.CALC_MODE_STANDARD), '-3');
+      expect(evaluate('0.1 + 0.2', CalcMode.CALC_MODE_STANDARD), '0.3');
+    });
+
+    test('matches keystroke result for 1 / 3', () {
+      sendNumber(calc, 1);
+      calculator_send_command(calc, CMD_DIVIDE);
+      sendNumber(calc, 3);
+      calculator_send_command(calc, CMD_EQUALS);
+
+      expect(evaluate('1 / 3', CalcMode.CALC_MODE_STANDARD), getDisplayResult(calc));
+    });
+
+    test('division by zero is reported as an error', () {
+      expect(evaluate('5 / 0', CalcMode.CALC_MODE_STANDARD), isNull);
+    });
+
+    test('malformed expressions are rejected', () {
+      expect(evaluate('5 +', CalcMode.CALC_MODE_STANDARD), isNull);
+      expect(evaluate('(1 + 2', CalcMode.CALC_MODE_SCIENTIFIC), isNull);
+    });
+
+    test('standard mode rejects scientific operators', () {
+      expect(evaluate('2 ^ 3', CalcMode.CALC_MODE_STANDARD), isNull);
+      expect(evaluate('7 mod 4', CalcMode.CALC_MODE_STANDARD), isNull);
+      expect(evaluate('3 yroot 27', CalcMode.CALC_MODE_STANDARD), isNull);
+      expect(evaluate('3 yroot 27', CalcMode.CALC_MODE_SCIENTIFIC), isNotNull);
+    });
+  });
+
+  group('Display Event Queue', () {
+    test('queued events carry display text', () {
+      calculator_enable_event_queue(calc, 4096);
+      sendNumber(calc, 42);
+
+      final displays = drainEvents(calc)
+          .where((e) => e.$1 == CalcEventType.CALC_EVENT_PRIMARY_DISPLAY)
+          .map((e) => e.$3)
+          .toList();
+      expect(displays.last, '42');
+      expect(drainEvents(calc), isEmpty);
+    });
+
+    test('full queue drops events and reports them', () {
+      calculator_enable_event_queue(calc, 1);
+      for (int i = 0; i < 50; i++) {
+        sendNumber(calc, 7);
+      }
+
+      expect(calculator_get_dropped_event_count(calc), greaterThan(0));
+      expect(calculator_get_dropped_event_count(calc), 0);
+    });
+
+    test('a record larger than the buffer reports its size', () {
+      calculator_enable_event_queue(calc, 4096);
+      sendNumber(calc, 42);
+
+      final small = calloc<Uint8>(8);
+      try {
+        final required = calculator_drain_events(calc, small.cast(), 8);
+        expect(required, lessThan(-8));
+        expect(calculator_drain_events(calc, nullptr, 0), required);
+      } finally {
+        calloc.free(small);
+      }
+
+      // Nothing was consumed, so a large enough buffer still receives every event
+      final displays = drainEvents(calc)
+          .where((e) => e.$1 == CalcEventType.CALC_EVENT_PRIMARY_DISPLAY)
+          .map((e) => e.$3)
+          .toList();
+      expect(displays.last, '42');
+    });
+
+    test('disabling the queue restores direct reads', () {
+      calculator_enable_event_queue(calc, 4096);
+      calculator_enable_event_queue(calc, 0);
+      sendNumber(calc, 5);
+
+      expect(drainEvents(calc), isEmpty);
+      expect(getDisplayResult(calc), '5');
+    });
+
+    test('coalescing delivers one notification per changed field', () {
+      const commands = [CMD_7, CMD_ADD, CMD_8, CMD_EQUALS];
+      const stateEvents = [
+        CalcEventType.CALC_EVENT_PRIMARY_DISPLAY,
+        CalcEventType.CALC_EVENT_EXPRESSION,
+        CalcEventType.CALC_EVENT_IS_IN_ERROR,
+        CalcEventType.CALC_EVENT_PARENTHESIS,
+        CalcEventType.CALC_EVENT_INPUT_CHANGED,
+      ];
+
+      /// Runs `commands` and returns the queued events of each one
+      List<List<(CalcEventType, int, String?)>> record(Pointer<CalculatorInstance> instance, bool coalesce) {
+        calculator_enable_event_queue(instance, 4096);
+        calculator_set_callback_coalescing(instance, coalesce ? 1 : 0);
+        final events = <List<(CalcEventType, int, String?)>>[];
+        for (final command in commands) {
+          calculator_send_command(instance, command);
+          events.add(drainEvents(instance));
+        }
+        return events;
+      }
+
+      final coalescedCalc = calculator_create();
+      try {
+        final plain = record(calc, false);
+        final coalesced = record(coalescedCalc, true);
+
+        for (var i = 0; i < commands.length; i++) {
+          final displays = coalesced[i].where((e) => e.$1 == CalcEventType.CALC_EVENT_PRIMARY_DISPLAY);
+          expect(displays.length, 1, reason: 'display after command $i');
+          for (final type in stateEvents) {
+            final plainCount = plain[i].where((e) => e.$1 == type).length;
+            final coalescedCount = coalesced[i].where((e) => e.$1 == type).length;
+            expect(coalescedCount, plainCount > 0 ? 1 : 0, reason: '$type after command $i');
+          }
+        }
+
+        final plainTotal = plain.fold<int>(0, (sum, events) => sum + events.length);
+        final coalescedTotal = coalesced.fold<int>(0, (sum, events) => sum + events.length);
+        expect(coalescedTotal, lessThan(plainTotal));
+
+        // The last value of each field is the same either way
+        for (final type in stateEvents) {
+          final plainLast = plain.expand((e) => e).where((e) => e.$1 == type).lastOrNull;
+          final coalescedLast = coalesced.expand((e) => e).where((e) => e.$1 == type).lastOrNull;
+          expect(coalescedLast, plainLast, reason: '$type');
+        }
+        expect(getDisplayResult(coalescedCalc), '15');
+        expect(getExpression(coalescedCalc), getExpression(calc));
+      } finally {
+        calculator_destroy(coalescedCalc);
+      }
+    });
+  });
+
+  group('Locale Pack', () {
+    tearDown(() {
+      calculator_set_locale(nullptr);
+    });
+
+    Pointer<CalculatorInstance> createWithDecimal(String separator) {
+      final locale = calloc<CalcLocale>();
+      final decimal = separator.toNativeUtf8();
+      try {
+        locale.ref.decimal_separator = decimal.cast();
+        calculator_set_locale(locale);
+        return calculator_create();
+      } finally {
+        calloc.free(decimal);
+        calloc.free(locale);
+      }
+    }
+
+    test('new instances use the configured decimal separator', () {
+      final localized = createWithDecimal(',');
+      try {
+        sendCommands(localized, [CMD_2, CMD_DIVIDE, CMD_4, CMD_EQUALS]);
+        expect(getDisplayResult(localized), '0,5');
+      } finally {
+        calculator_destroy(localized);
+      }
+    });
+
+    test('existing instances keep their locale', () {
+      final localized = createWithDecimal(',');
+      calculator_destroy(localized);
+
+      sendCommands(calc, [CMD_2, CMD_DIVIDE, CMD_4, CMD_EQUALS]);
+      expect(getDisplayResult(calc), '0.5');
+    });
+
+    test('NULL locale restores the defaults', () {
+      calculator_destroy(createWithDecimal(','));
+      calculator_set_locale(nullptr);
+
+      final restored = calculator_create();
+      try {
+        sendCommands(restored, [CMD_2, CMD_DIVIDE, CMD_4, CMD_EQUALS]);
+        expect(getDisplayResult(restored), '0.5');
+      } finally {
+        calculator_destroy(restored);
+      }
+    });
+  });
+
+  group('History Serialization', () {
+    List<(String, String)> historyOf(Pointer<CalculatorInstance> instance) => [
+      for (var i = 0; i < calculator_history_get_count(instance); i++)
+        (
+          readString((buffer, size) => calculator_history_get_expression_at(instance, i, buffer, size)),
+          readString((buffer, size) => calculator_history_get_result_at(instance, i, buffer, size)),
+        ),
+    ];
+
+    test('save and restore round-trips history into a new instance', () {
+      sendCommands(calc, [CMD_1, CMD_ADD, CMD_2, CMD_EQUALS, CMD_3, CMD_MULTIPLY, CMD_4, CMD_EQUALS]);
+      expect(calculator_history_get_count(calc), 2);
+
+      final size = calculator_history_save(calc, CalcMode.CALC_MODE_STANDARD, nullptr, 0);
+      expect(size, greaterThan(0));
+      final blob = calloc<Uint8>(size);
+      final restored = calculator_create();
+      try {
+        expect(calculator_history_save(calc, CalcMode.CALC_MODE_STANDARD, blob.cast(), size), size);
+        expect(calculator_history_restore(restored, CalcMode.CALC_MODE_STANDARD, blob.cast(), size), 2);
+        expect(historyOf(restored), historyOf(calc));
+
+        // Expression commands survive, so loading an item replays it
+        calculator_history_load_at(restored, 1);
+        expect(getDisplayResult(restored), '12');
+      } finally {
+        calculator_destroy(restored);
+        calloc.free(blob);
+      }
+    });
+
+    test('restore rejects truncated data and keeps the history', () {
+      sendCommands(calc, [CMD_1, CMD_ADD, CMD_2, CMD_EQUALS]);
+      final size = calculator_history_save(calc, CalcMode.CALC_MODE_STANDARD, nullptr, 0);
+      final blob = calloc<Uint8>(size);
+      try {
+        calculator_history_save(calc, CalcMode.CALC_MODE_STANDARD, blob.cast(), size);
+        expect(calculator_history_restore(calc, CalcMode.CALC_MODE_STANDARD, blob.cast(), size - 1), -2);
+        expect(calculator_history_get_count(calc), 1);
+      } finally {
+        calloc.free(blob);
+      }
+    });
+
+    test('set_from_vector restores expressions and results from JSON', () {
+      final json = '[{"expression": "1 + 2 =", "result": "3"}, {"expression": "6 \u00F7 3 =", "result": "2"}]'
+          .toNativeUtf8();
+      try {
+        calculator_history_set_from_vector(calc, json.cast());
+      } finally {
+        calloc.free(json);
+      }
+      expect(historyOf(calc), [('1 + 2 =', '3'), ('6 ÷ 3 =', '2')]);
+    });
+
+    test('set_from_vector ignores malformed JSON', () {
+      sendCommands(calc, [CMD_1, CMD_ADD, CMD_2, CMD_EQUALS]);
+      final json = '[{"expression": "1 + 2 ="'.toNativeUtf8();
+      try {
+        calculator_history_set_from_vector(calc, json.cast());
+      } finally {
+        calloc.free(json);
+      }
+      expect(calculator_history_get_count(calc), 1);
+    });
+  });
+
+  group('Instance Snapshot', () {
+    late Pointer<CalculatorInstance> restored;
+
+    setUp(() {
+      restored = calculator_create();
+    });
+
+    tearDown(() {
+      calculator_destroy(restored);
+    });
+
+    /// Snapshots `source` and restores it into `target`, returning calculator_restore's result
+    int copyState(Pointer<CalculatorInstance> source, Pointer<CalculatorInstance> target) {
+      final len = calloc<Size>();
+      try {
+        expect(calculator_snapshot(source, nullptr, len), 1);
+        final buf = calloc<Uint8>(len.value);
+        try {
+          expect(calculator_snapshot(source, buf.cast(), len), 0);
+          return calculator_restore(target, buf.cast(), len.value);
+        } finally {
+          calloc.free(buf);
+        }
+      } finally {
+        calloc.free(len);
+      }
+    }
+
+    List<String> memoryOf(Pointer<CalculatorInstance> instance) => [
+      for (var i = 0; i < calculator_memory_get_count(instance); i++)
+        readString((buffer, size) => calculator_memory_get_at(instance, i, buffer, size)),
+    ];
+
+    test('pending operation continues after restore', () {
+      sendCommands(calc, [CMD_1, CMD_2, CMD_ADD, CMD_3, CMD_MULTIPLY, CMD_4]);
+      expect(copyState(calc, restored), 0);
+      expect(getDisplayResult(restored), getDisplayResult(calc));
+
+      sendCommands(calc, [CMD_EQUALS]);
+      sendCommands(restored, [CMD_EQUALS]);
+      expect(getDisplayResult(restored), getDisplayResult(calc));
+    });
+
+    test('operator awaiting its operand is restored without one', () {
+      sendCommands(calc, [CMD_5, CMD_ADD]);
+      expect(copyState(calc, restored), 0);
+
+      sendCommands(restored, [CMD_3, CMD_EQUALS]);
+      expect(getDisplayResult(restored), '8');
+    });
+
+    test('result after equals is restored as a result', () {
+      sendCommands(calc, [CMD_5, CMD_ADD, CMD_3, CMD_EQUALS]);
+      expect(copyState(calc, restored), 0);
+      expect(getDisplayResult(restored), '8');
+
+      for (final instance in [calc, restored]) {
+        sendCommands(instance, [CMD_2]);
+        expect(getDisplayResult(instance), '2');
+        sendCommands(instance, [CMD_ADD, CMD_1, CMD_EQUALS]);
+      }
+      expect(getDisplayResult(restored), '3');
+      expect(getDisplayResult(calc), '3');
+    });
+
+    test('result after equals keeps full precision', () {
+      sendCommands(calc, [CMD_1, CMD_DIVIDE, CMD_3, CMD_EQUALS]);
+      expect(copyState(calc, restored), 0);
+
+      sendCommands(restored, [CMD_MULTIPLY, CMD_3, CMD_EQUALS]);
+      expect(getDisplayResult(restored), '1');
+    });
+
+    test('open parentheses are restored in scientific mode', () {
+      calculator_set_scientific_mode(calc);
+      sendCommands(calc, [CMD_2, CMD_MULTIPLY, CMD_OPENP, CMD_3, CMD_ADD, CMD_4]);
+      expect(copyState(calc, restored), 0);
+      expect(calculator_get_current_mode(restored), CalcMode.CALC_MODE_SCIENTIFIC.value);
+      expect(calculator_get_parenthesis_count(restored), 1);
+
+      sendCommands(restored, [CMD_CLOSEP, CMD_EQUALS]);
+      expect(getDisplayResult(restored), '14');
+    });
+
+    test('settings, memory and history are restored', () {
+      calculator_set_scientific_mode(calc);
+      calculator_set_angle_type(calc, CalcAngleType.CALC_ANGLE_RADIANS);
+      calculator_set_carry_flag(calc, 1);
+      sendCommands(calc, [CMD_7, CMD_ADD, CMD_1, CMD_EQUALS]);
+      calculator_memory_store(calc);
+      sendCommands(calc, [CMD_CLEAR, CMD_2, CMD_DECIMAL, CMD_5]);
+      calculator_memory_store(calc);
+
+      expect(copyState(calc, restored), 0);
+      expect(calculator_get_angle_type(restored), CalcAngleType.CALC_ANGLE_RADIANS.value);
+      expect(calculator_get_carry_flag(restored), 1);
+      expect(memoryOf(restored), memoryOf(calc));
+      expect(calculator_history_get_count(restored), calculator_history_get_count(calc));
+      expect(getDisplayResult(restored), '2.5');
+    });
+
+    test('memory keeps full precision', () {
+      sendCommands(calc, [CMD_1, CMD_DIVIDE, CMD_3, CMD_EQUALS]);
+      calculator_memory_store(calc);
+      sendCommands(calc, [CMD_CLEAR]);
+
+      expect(copyState(calc, restored), 0);
+      expect(memoryOf(restored), memoryOf(calc));
+      calculator_memory_recall(restored);
+      sendCommands(restored, [CMD_MULTIPLY, CMD_3, CMD_EQUALS]);
+      expect(getDisplayResult(restored), '1');
+    });
+
+    test('memory added to and subtracted from keeps full precision', () {
+      sendCommands(calc, [CMD_2, CMD_DIVIDE, CMD_3, CMD_EQUALS]);
+      calculator_memory_store(calc);
+      sendCommands(calc, [CMD_1, CMD_DIVIDE, CMD_3, CMD_EQUALS]);
+      calculator_memory_subtract(calc);
+      sendCommands(calc, [CMD_5]);
+      calculator_memory_store(calc);
+      calculator_memory_add_at(calc, 0);
+      sendCommands(calc, [CMD_CLEAR]);
+
+      expect(copyState(calc, restored), 0);
+      expect(memoryOf(restored), memoryOf(calc));
+      expect(memoryOf(restored)[0], '10');
+      calculator_memory_load_at(restored, 1);
+      sendCommands(restored, [CMD_MULTIPLY, CMD_3, CMD_EQUALS]);
+      expect(getDisplayResult(restored), '1');
+    });
+
+    test('error state is restored with its message', () {
+      for (final commands in [
+        [CMD_1, CMD_DIVIDE, CMD_0, CMD_EQUALS],
+        [CMD_0, CMD_DIVIDE, CMD_0, CMD_EQUALS],
+      ]) {
+        sendCommands(calc, [CMD_CLEAR, ...commands]);
+        expect(calculator_has_error(calc), 1);
+
+        expect(copyState(calc, restored), 0);
+        expect(calculator_has_error(restored), 1);
+        expect(getDisplayResult(restored), getDisplayResult(calc));
+      }
+    });
+
+    test('programmer radix and word width are restored', () {
+      calculator_set_programmer_mode(calc);
+      calculator_set_word_width(calc, CalcWordType.CALC_WORD_BYTE);
+      calculator_set_radix(calc, CalcRadixType.CALC_RADIX_HEX);
+      sendCommands(calc, [CMD_A, CMD_B]);
+
+      expect(copyState(calc, restored), 0);
+      expect(calculator_get_radix(restored), CalcRadixType.CALC_RADIX_HEX.value);
+      expect(calculator_get_word_width(restored), CalcWordType.CALC_WORD_BYTE.value);
+      expect(getDisplayResult(restored), getDisplayResult(calc));
+    });
+
+    test('restore rejects malformed data and keeps the state', () {
+      sendNumber(restored, 42);
+      final junk = calloc<Uint8>(16);
+      try {
+        expect(calculator_restore(restored, junk.cast(), 16), -2);
+        expect(getDisplayResult(restored), '42');
+      } finally {
+        calloc.free(junk);
+      }
+    });
+  });
+
   group('Input Validation', () {
     test('isInputEmpty returns true initially', () {
       expect(calculator_is_input_empty(calc) != 0, isTrue);